@@ -15,5 +15,25 @@ set_property(TEST ${compile_name} PROPERTY TIMEOUT -1)
 set_tests_properties(${compile_name} PROPERTIES FIXTURES_SETUP compile)
 
 ttest(reassembler_dup)
+ttest(send_sack)
+ttest(send_sack_space)
+ttest(send_congestion)
+ttest(send_rto)
+ttest(send_options)
+ttest(send_mtu_probe)
+ttest(send_pacing)
+ttest(send_nagle)
+ttest(send_persist)
+ttest(send_stream_peek)
+ttest(send_autotune)
+ttest(recv_delayed_ack)
+ttest(recv_autotune)
+ttest(recv_header_prediction)
+ttest(recv_window_update)
+ttest(recv_syn_cookie)
+ttest(send_tso_coalesce)
+ttest(stack_spsc_queue)
+ttest(stack_shard_hash)
+ttest(stack_listen_backlog)
 
-add_custom_target (check COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^reassembler_')
\ No newline at end of file
+add_custom_target (check COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --stop-on-failure --timeout 12 -R '^reassembler_|^send_|^recv_|^stack_')
\ No newline at end of file
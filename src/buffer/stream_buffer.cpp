@@ -1,6 +1,7 @@
 #include "buffer/stream_buffer.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <stdexcept>
 
@@ -8,7 +9,9 @@ using namespace std;
 
 StreamBuffer::StreamBuffer(uint64_t capacity) : capacity_(capacity) {}
 
-void Writer::push(string data) {
+void Writer::push(string data) { push(Buffer{std::move(data)}); }
+
+void Writer::push(Buffer data) {
   const auto write_num = min(available_capacity(), data.size());
   if (!write_num) {
     return;
@@ -17,9 +20,26 @@ void Writer::push(string data) {
   if (data.size() > write_num) {
     data = data.substr(0, write_num);
   }
-  _buffer.push(std::move(data));
-  if (_buffer.size() == 1) {
-    _front_view = _buffer.front();
+
+  if (write_num < SMALL_WRITE) {
+    // 队首的块可能已被部分 pop，追加后保留原来的起点
+    const size_t popped =
+        _buffer.empty() ? 0 : _buffer.front().size() - _front_view.size();
+    if (!_merging || !_buffer.back().try_append(data)) {
+      string chunk;
+      chunk.reserve(MERGED_CHUNK);
+      chunk.append(string_view{data});
+      // 显式长度的切片：之后的追加只延长这一个切片
+      _buffer.emplace_back(Buffer{std::move(chunk)}.substr(0));
+      _merging = true;
+    }
+    _front_view = string_view{_buffer.front()}.substr(popped);
+  } else {
+    _buffer.emplace_back(std::move(data));
+    _merging = false;
+    if (_buffer.size() == 1) {
+      _front_view = _buffer.front();
+    }
   }
   _bytes_pushed += write_num;
   _bytes_buffered += write_num;
@@ -29,8 +49,14 @@ void Writer::close() { _closed = true; }
 
 void Writer::set_error() { _error = true; }
 
+void Writer::set_capacity(uint64_t capacity) {
+  capacity_ = max(capacity, uint64_t{_bytes_buffered});
+}
+
 bool Writer::is_closed() const { return _closed; }
 
+uint64_t Writer::capacity() const { return capacity_; }
+
 uint64_t Writer::available_capacity() const {
   return capacity_ - _bytes_buffered;
 }
@@ -51,20 +77,61 @@ void Reader::pop(uint64_t len) {
   while (len && !_buffer.empty()) {
     const size_t firstsize = _front_view.size();
     if (len >= firstsize) {
-      _buffer.pop();
+      // 游标所在的块被弹出时移到新的队首，新队首紧接在它之后
+      if (_cursor_chunk) {
+        _cursor_chunk -= 1;
+      } else {
+        _cursor_start += _buffer.front().size();
+      }
+      _buffer.pop_front();
       if (!_buffer.empty()) {
         _front_view = _buffer.front();
+      } else {
+        _merging = false;
       }
       len -= firstsize;
       continue;
     }
-    _front_view.remove_prefix(pop_num);
+    _front_view.remove_prefix(len);
     len = 0;
   }
   _bytes_popped += pop_num;
   _bytes_buffered -= pop_num;
 }
 
+Buffer Reader::peek(uint64_t offset, uint64_t len) const {
+  len = min(len, _bytes_buffered - min(offset, _bytes_buffered));
+  if (!len) {
+    return {};
+  }
+
+  // 在流中的位置；队首的块可能已被部分 pop
+  const uint64_t pos = _bytes_popped + offset;
+  if (pos < _cursor_start) {
+    _cursor_chunk = 0;
+    _cursor_start =
+        _bytes_popped - (_buffer.front().size() - _front_view.size());
+  }
+  while (pos >= _cursor_start + _buffer[_cursor_chunk].size()) {
+    _cursor_start += _buffer[_cursor_chunk].size();
+    _cursor_chunk += 1;
+  }
+
+  auto it = _buffer.begin() + static_cast<ptrdiff_t>(_cursor_chunk);
+  offset = pos - _cursor_start;
+  if (offset + len <= it->size()) {
+    return it->substr(offset, len);
+  }
+
+  string out;
+  out.reserve(len);
+  for (; it != _buffer.end() && out.size() < len; ++it) {
+    out += string_view{*it}.substr(offset, len - out.size());
+    offset = 0;
+  }
+  return out;
+}
+
 uint64_t Reader::bytes_buffered() const { return _bytes_buffered; }
 
 uint64_t Reader::bytes_popped() const { return _bytes_popped; }
@@ -0,0 +1,202 @@
+#include "congestion/bbr.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+uint64_t Bbr::btl_bw() const {
+  return bw_filter_.empty() ? 0 : bw_filter_.front().second;
+}
+
+uint64_t Bbr::bdp(double gain) const {
+  if (!btl_bw() || min_rtt_ms_ == UINT64_MAX) {
+    return initial_cwnd_;
+  }
+  return static_cast<uint64_t>(gain * static_cast<double>(btl_bw()) *
+                               static_cast<double>(min_rtt_ms_) / 1000);
+}
+
+void Bbr::on_ack(const AckEvent& ack) {
+  // 新的一轮：被确认的报文是在上一轮开始之后发送的
+  round_start_ = false;
+  if (ack.rate.valid && ack.rate.prior_delivered >= next_round_delivered_) {
+    next_round_delivered_ = ack.delivered;
+    round_count_ += 1;
+    round_start_ = true;
+  }
+
+  update_bandwidth(ack);
+  check_full_pipe(ack);
+  update_min_rtt(ack);
+  update_state(ack);
+  set_pacing_rate();
+  set_cwnd(ack);
+}
+
+void Bbr::update_bandwidth(const AckEvent& ack) {
+  while (!bw_filter_.empty() &&
+         bw_filter_.front().first + BW_WINDOW_ROUNDS <= round_count_) {
+    bw_filter_.pop_front();
+  }
+
+  const auto& rs = ack.rate;
+  if (!rs.valid || !rs.delivery_rate) {
+    return;
+  }
+  // 受应用限制的样本只能提高估计值，不能拉低
+  if (rs.app_limited && rs.delivery_rate < btl_bw()) {
+    return;
+  }
+  while (!bw_filter_.empty() && bw_filter_.back().second <= rs.delivery_rate) {
+    bw_filter_.pop_back();
+  }
+  bw_filter_.emplace_back(round_count_, rs.delivery_rate);
+}
+
+void Bbr::check_full_pipe(const AckEvent& ack) {
+  if (filled_pipe_ || !round_start_ || ack.rate.app_limited) {
+    return;
+  }
+  // 连续三轮带宽增长不足 25%，认为管道已满
+  if (static_cast<double>(btl_bw()) >= static_cast<double>(full_bw_) * 1.25) {
+    full_bw_ = btl_bw();
+    full_bw_count_ = 0;
+    return;
+  }
+  full_bw_count_ += 1;
+  filled_pipe_ = full_bw_count_ >= 3;
+}
+
+void Bbr::update_min_rtt(const AckEvent& ack) {
+  const bool expired = min_rtt_ms_ != UINT64_MAX &&
+                       ack.now_ms > min_rtt_stamp_ + MIN_RTT_WINDOW_MS;
+  const auto& rtt = ack.rate.rtt_ms;
+  if (rtt && (rtt.value() <= min_rtt_ms_ || expired)) {
+    min_rtt_ms_ = max(rtt.value(), uint64_t{1});
+    min_rtt_stamp_ = ack.now_ms;
+  }
+
+  if (expired && state_ != State::ProbeRTT) {
+    state_ = State::ProbeRTT;
+    pacing_gain_ = 1;
+    cwnd_gain_ = 1;
+    save_cwnd();
+    probe_rtt_done_stamp_ = 0;
+  }
+
+  if (state_ != State::ProbeRTT) {
+    return;
+  }
+  // 把在途数据压到最低，保持 PROBE_RTT_DURATION_MS 且至少一轮
+  if (!probe_rtt_done_stamp_ && ack.in_flight <= MIN_CWND_SEGMENTS * mss_) {
+    probe_rtt_done_stamp_ = ack.now_ms + PROBE_RTT_DURATION_MS;
+    probe_rtt_round_done_ = false;
+    next_round_delivered_ = ack.delivered;
+  } else if (probe_rtt_done_stamp_) {
+    probe_rtt_round_done_ |= round_start_;
+    if (probe_rtt_round_done_ && ack.now_ms > probe_rtt_done_stamp_) {
+      min_rtt_stamp_ = ack.now_ms;
+      cwnd_ = max(cwnd_, prior_cwnd_);
+      if (filled_pipe_) {
+        enter_probe_bw(ack.now_ms);
+      } else {
+        state_ = State::Startup;
+        pacing_gain_ = HIGH_GAIN;
+        cwnd_gain_ = HIGH_GAIN;
+      }
+    }
+  }
+}
+
+void Bbr::update_state(const AckEvent& ack) {
+  if (state_ == State::Startup && filled_pipe_) {
+    state_ = State::Drain;
+    pacing_gain_ = 1 / HIGH_GAIN;
+    cwnd_gain_ = HIGH_GAIN;
+  }
+  if (state_ == State::Drain && ack.in_flight <= bdp(1)) {
+    enter_probe_bw(ack.now_ms);
+  }
+
+  if (state_ != State::ProbeBW) {
+    return;
+  }
+  // 每个 min RTT 切换一次增益；探测阶段需要在途量达到目标，
+  // 排空阶段在在途量回落到 BDP 时可以提前结束
+  bool advance = ack.now_ms - cycle_stamp_ > min_rtt_ms_;
+  if (pacing_gain_ > 1) {
+    advance &= ack.in_flight >= bdp(pacing_gain_);
+  } else if (pacing_gain_ < 1) {
+    advance |= ack.in_flight <= bdp(1);
+  }
+  if (advance) {
+    cycle_index_ = (cycle_index_ + 1) % size(PACING_GAIN_CYCLE);
+    cycle_stamp_ = ack.now_ms;
+    pacing_gain_ = PACING_GAIN_CYCLE[cycle_index_];
+  }
+}
+
+void Bbr::enter_probe_bw(uint64_t now_ms) {
+  state_ = State::ProbeBW;
+  cwnd_gain_ = CWND_GAIN;
+  cycle_index_ = (now_ms / max(min_rtt_ms_, uint64_t{1})) %
+                 (size(PACING_GAIN_CYCLE) - 1);
+  // 跳过 0.75 的排空相位
+  cycle_index_ += cycle_index_ >= 1;
+  cycle_stamp_ = now_ms;
+  pacing_gain_ = PACING_GAIN_CYCLE[cycle_index_];
+}
+
+void Bbr::set_pacing_rate() {
+  const auto rate =
+      static_cast<uint64_t>(pacing_gain_ * static_cast<double>(btl_bw()));
+  // 管道未满之前只升不降
+  if (rate && (filled_pipe_ || rate > pacing_rate_)) {
+    pacing_rate_ = rate;
+  }
+}
+
+void Bbr::set_cwnd(const AckEvent& ack) {
+  const uint64_t min_cwnd = MIN_CWND_SEGMENTS * mss_;
+  if (state_ == State::ProbeRTT) {
+    cwnd_ = min(cwnd_, min_cwnd);
+    return;
+  }
+
+  if (ack.in_recovery) {
+    // 包守恒：恢复期间每确认多少就发送多少
+    if (packet_conservation_) {
+      cwnd_ = max(cwnd_, ack.in_flight + ack.acked);
+    }
+    cwnd_ = max(cwnd_, min_cwnd);
+    return;
+  }
+  if (packet_conservation_) {
+    packet_conservation_ = false;
+    cwnd_ = max(cwnd_, prior_cwnd_);
+  }
+
+  const uint64_t target = bdp(cwnd_gain_) + 3 * mss_;
+  if (filled_pipe_) {
+    cwnd_ = min(cwnd_ + ack.acked, target);
+  } else if (cwnd_ < target || ack.delivered < initial_cwnd_) {
+    cwnd_ += ack.acked;
+  }
+  cwnd_ = max(cwnd_, min_cwnd);
+}
+
+void Bbr::save_cwnd() {
+  prior_cwnd_ = packet_conservation_ ? max(prior_cwnd_, cwnd_) : cwnd_;
+}
+
+void Bbr::on_loss(uint64_t in_flight, uint64_t) {
+  save_cwnd();
+  packet_conservation_ = true;
+  cwnd_ = max(in_flight, MIN_CWND_SEGMENTS * mss_);
+}
+
+void Bbr::on_rto(uint64_t, uint64_t) {
+  save_cwnd();
+  cwnd_ = mss_;
+}
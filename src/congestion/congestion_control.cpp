@@ -0,0 +1,24 @@
+#include "congestion/congestion_control.h"
+
+#include <stdexcept>
+
+#include "congestion/bbr.h"
+#include "congestion/cubic.h"
+#include "congestion/new_reno.h"
+
+using namespace std;
+
+unique_ptr<CongestionControl> make_congestion_control(const TCPConfig& cfg,
+                                                     uint64_t mss) {
+  const uint64_t initial_cwnd = TCPConfig::INITIAL_CWND * mss;
+
+  switch (cfg.congestion_control) {
+    case CongestionAlgorithm::NewReno:
+      return make_unique<NewReno>(mss, initial_cwnd);
+    case CongestionAlgorithm::Cubic:
+      return make_unique<Cubic>(mss, initial_cwnd);
+    case CongestionAlgorithm::Bbr:
+      return make_unique<Bbr>(mss, initial_cwnd);
+  }
+  throw runtime_error("unknown congestion control algorithm");
+}
@@ -0,0 +1,70 @@
+#include "congestion/cubic.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+void Cubic::reduce() {
+  // fast convergence: 窗口比上次丢包时还小，说明有新流加入，主动让出带宽
+  if (segments() < w_max_) {
+    w_max_ = segments() * (1 + BETA) / 2;
+  } else {
+    w_max_ = segments();
+  }
+  ssthresh_ = max(static_cast<uint64_t>(static_cast<double>(cwnd_) * BETA),
+                  2 * mss_);
+  epoch_started_ = false;
+  cwnd_fraction_ = 0;
+}
+
+void Cubic::on_ack(const AckEvent& ack) {
+  if (ack.in_recovery) {
+    return;
+  }
+
+  if (in_slow_start()) {
+    cwnd_ += min(ack.acked, 2 * mss_);
+    return;
+  }
+
+  if (!epoch_started_) {
+    epoch_started_ = true;
+    epoch_start_ = ack.now_ms;
+    w_est_ = segments();
+    if (segments() < w_max_) {
+      k_ = cbrt((w_max_ - segments()) / C);
+    } else {
+      k_ = 0;
+      w_max_ = segments();
+    }
+  }
+
+  const double t = static_cast<double>(ack.now_ms - epoch_start_) / 1000;
+  double target = C * pow(t - k_, 3) + w_max_;
+
+  // Reno 友好区间：保证不比标准 Reno 慢
+  constexpr double alpha = 3 * (1 - BETA) / (1 + BETA);
+  w_est_ += alpha * (static_cast<double>(ack.acked) / mss_) / segments();
+  target = max(target, w_est_);
+
+  // 每个 RTT 的增长不超过当前窗口的一半
+  target = min(target, 1.5 * segments());
+  if (target > segments()) {
+    cwnd_fraction_ +=
+        (target - segments()) / segments() * static_cast<double>(ack.acked);
+    const auto inc = static_cast<uint64_t>(cwnd_fraction_);
+    cwnd_ += inc;
+    cwnd_fraction_ -= static_cast<double>(inc);
+  }
+}
+
+void Cubic::on_loss(uint64_t, uint64_t) {
+  reduce();
+  cwnd_ = ssthresh_;
+}
+
+void Cubic::on_rto(uint64_t, uint64_t) {
+  reduce();
+  cwnd_ = mss_;
+}
@@ -0,0 +1,75 @@
+#include "congestion/delivery_rate.h"
+
+#include <algorithm>
+
+using namespace std;
+
+PacketDeliveryInfo DeliveryRateSampler::on_send(uint64_t now_ms, bool idle,
+                                                bool retransmitted) {
+  if (idle) {
+    first_sent_ms_ = now_ms;
+    delivered_ms_ = now_ms;
+  }
+  return {
+      .delivered = delivered_,
+      .delivered_ms = delivered_ms_,
+      .first_sent_ms = first_sent_ms_,
+      .sent_ms = now_ms,
+      .app_limited = app_limited_until_ != 0,
+      .retransmitted = retransmitted,
+  };
+}
+
+void DeliveryRateSampler::on_delivered(const PacketDeliveryInfo& info,
+                                       uint64_t bytes, uint64_t now_ms) {
+  delivered_ += bytes;
+  delivered_ms_ = now_ms;
+
+  // 以本次 ACK 中最晚发送的报文作为样本
+  if (!have_sample_ || info.delivered > prior_delivered_) {
+    have_sample_ = true;
+    prior_delivered_ = info.delivered;
+    prior_delivered_ms_ = info.delivered_ms;
+    send_elapsed_ms_ = info.sent_ms - info.first_sent_ms;
+    sample_app_limited_ = info.app_limited;
+    first_sent_ms_ = info.sent_ms;
+    if (info.retransmitted) {
+      sample_rtt_ms_.reset();
+    } else {
+      sample_rtt_ms_ = now_ms - info.sent_ms;
+    }
+  }
+}
+
+RateSample DeliveryRateSampler::generate() {
+  if (app_limited_until_ && delivered_ > app_limited_until_) {
+    app_limited_until_ = 0;
+  }
+  if (!have_sample_) {
+    return {};
+  }
+  have_sample_ = false;
+
+  const uint64_t ack_elapsed_ms = delivered_ms_ - prior_delivered_ms_;
+  RateSample rs{
+      .valid = true,
+      .delivered = delivered_ - prior_delivered_,
+      .interval_ms = max({send_elapsed_ms_, ack_elapsed_ms, uint64_t{1}}),
+      .prior_delivered = prior_delivered_,
+      .rtt_ms = sample_rtt_ms_,
+      .app_limited = sample_app_limited_,
+  };
+  rs.delivery_rate = rs.delivered * 1000 / rs.interval_ms;
+
+  if (!rs.app_limited || rs.delivery_rate > last_rate_) {
+    last_rate_ = rs.delivery_rate;
+  }
+  if (rs.rtt_ms && (!min_rtt_ms_ || rs.rtt_ms < min_rtt_ms_)) {
+    min_rtt_ms_ = rs.rtt_ms;
+  }
+  return rs;
+}
+
+void DeliveryRateSampler::set_app_limited(uint64_t in_flight) {
+  app_limited_until_ = max(delivered_ + in_flight, uint64_t{1});
+}
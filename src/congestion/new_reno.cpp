@@ -0,0 +1,34 @@
+#include "congestion/new_reno.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void NewReno::on_ack(const AckEvent& ack) {
+  if (ack.in_recovery) {
+    return;
+  }
+
+  if (in_slow_start()) {
+    cwnd_ += min(ack.acked, 2 * mss_);
+    return;
+  }
+
+  bytes_acked_ += ack.acked;
+  if (bytes_acked_ >= cwnd_) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void NewReno::on_loss(uint64_t in_flight, uint64_t) {
+  ssthresh_ = max(in_flight / 2, 2 * mss_);
+  cwnd_ = ssthresh_;
+  bytes_acked_ = 0;
+}
+
+void NewReno::on_rto(uint64_t in_flight, uint64_t) {
+  ssthresh_ = max(in_flight / 2, 2 * mss_);
+  cwnd_ = mss_;
+  bytes_acked_ = 0;
+}
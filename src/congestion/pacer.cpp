@@ -0,0 +1,56 @@
+#include "congestion/pacer.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static constexpr double US_PER_SEC = 1e6;
+
+void Pacer::refill(uint64_t now_us) {
+  if (last_us_ && now_us > last_us_.value()) {
+    const auto elapsed = static_cast<double>(now_us - last_us_.value());
+    tokens_ += elapsed * static_cast<double>(rate_) / US_PER_SEC;
+  }
+  if (!last_us_ || now_us > last_us_.value()) {
+    last_us_ = now_us;
+  }
+  tokens_ = min(tokens_, static_cast<double>(burst_));
+}
+
+void Pacer::set_rate(uint64_t now_us, uint64_t rate, uint64_t burst) {
+  if (!rate_) {
+    // 不限速时桶视为满的，开始限速后允许立即发出一个突发
+    tokens_ = static_cast<double>(burst);
+    last_us_ = now_us;
+  } else {
+    refill(now_us);
+  }
+  rate_ = rate;
+  burst_ = burst;
+  tokens_ = min(tokens_, static_cast<double>(burst_));
+}
+
+bool Pacer::try_send(uint64_t now_us, uint64_t bytes) {
+  if (!rate_) {
+    return true;
+  }
+  refill(now_us);
+  if (tokens_ < static_cast<double>(min(bytes, burst_))) {
+    return false;
+  }
+  tokens_ -= static_cast<double>(bytes);
+  return true;
+}
+
+uint64_t Pacer::delay_us(uint64_t bytes) const {
+  if (!rate_) {
+    return 0;
+  }
+  const double need = static_cast<double>(min(bytes, burst_)) - tokens_;
+  if (need <= 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(
+      ceil(need * US_PER_SEC / static_cast<double>(rate_)));
+}
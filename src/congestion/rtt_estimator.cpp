@@ -0,0 +1,49 @@
+#include "congestion/rtt_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+RttEstimator::RttEstimator(uint64_t initial_rto_ms, uint64_t min_rto_ms,
+                           uint64_t max_rto_ms, uint64_t granularity_ms)
+    : min_rto_ms_(min_rto_ms),
+      max_rto_ms_(max(max_rto_ms, min_rto_ms)),
+      granularity_ms_(granularity_ms),
+      rto_ms_(clamp(initial_rto_ms, min_rto_ms_, max_rto_ms_)) {}
+
+void RttEstimator::on_sample(uint64_t rtt_ms, uint64_t samples_per_rtt) {
+  const auto r = static_cast<double>(rtt_ms);
+  const auto n = static_cast<double>(max(samples_per_rtt, uint64_t{1}));
+  if (!srtt_ms_) {
+    // (2.2) 第一个样本
+    srtt_ms_ = r;
+    rttvar_ms_ = r / 2;
+  } else {
+    // (2.3) 先用旧的 SRTT 更新 RTTVAR
+    const double beta = BETA / n;
+    const double alpha = ALPHA / n;
+    rttvar_ms_ = (1 - beta) * rttvar_ms_ + beta * abs(srtt_ms_.value() - r);
+    srtt_ms_ = (1 - alpha) * srtt_ms_.value() + alpha * r;
+  }
+
+  const double rto =
+      srtt_ms_.value() +
+      max(static_cast<double>(granularity_ms_), K * rttvar_ms_);
+  rto_ms_ = clamp(static_cast<uint64_t>(ceil(rto)), min_rto_ms_, max_rto_ms_);
+}
+
+uint64_t RttEstimator::backed_off_rto_ms(unsigned backoff) const {
+  // 先判断是否会超过上限，避免移位溢出
+  if (backoff >= 63 || (rto_ms_ << backoff) >> backoff != rto_ms_) {
+    return max_rto_ms_;
+  }
+  return min(rto_ms_ << backoff, max_rto_ms_);
+}
+
+optional<uint64_t> RttEstimator::srtt_ms() const {
+  if (!srtt_ms_) {
+    return {};
+  }
+  return static_cast<uint64_t>(srtt_ms_.value());
+}
@@ -30,6 +30,10 @@ static inline uint64_t timestamp_ms() {
            1000000;
 }
 
+static inline uint64_t timestamp_us() {
+    return std::chrono::steady_clock::now().time_since_epoch().count() / 1000;
+}
+
 //! \param[in] condition 如果返回true，就应该继续循环
 template <typename AdaptT>
 void TCPSocket<AdaptT>::_tcp_loop(const function<bool()>& condition) {
@@ -78,6 +82,10 @@ void TCPSocket<AdaptT>::_initialize_TCP(const TCPConfig& config) {
         "receive TCP segment from the network", _datagram_adapter.fd(),
         Direction::In,
         [&] {
+            if (_syn_cookies and _datagram_adapter.listening()) {
+                _cookie_handshake();
+                return;
+            }
             if (auto seg = _datagram_adapter.read()) {
                 _tcp->receive(std::move(seg.value()));
                 collect_segments();
@@ -140,6 +148,8 @@ void TCPSocket<AdaptT>::_initialize_TCP(const TCPConfig& config) {
                 const std::string_view buffer = inbound.peek();
                 const auto bytes_written = _thread_data.write(buffer);
                 inbound.pop(bytes_written);
+                // 读出的数据腾出了窗口，必要时发送窗口更新
+                collect_segments();
             }
 
             if (inbound.is_finished() or inbound.has_error()) {
@@ -164,12 +174,33 @@ void TCPSocket<AdaptT>::_initialize_TCP(const TCPConfig& config) {
     _eventloop.add_rule(
         "send TCP segment", _datagram_adapter.fd(), Direction::Out,
         [&] {
+            const auto& transceiver = _tcp->transceiver();
+            const auto now = timestamp_us();
+            _pacer.set_rate(now, transceiver.pacing_rate(),
+                            transceiver.pacing_burst());
             while (not outgoing_segments_.empty()) {
-                _datagram_adapter.write(outgoing_segments_.front());
+                auto& seg = outgoing_segments_.front();
+                const auto bytes = IPv4Header::LENGTH + seg.header_length() +
+                                   seg.sender_message.payload.size();
+                if (not _pacer.try_send(now, bytes)) {
+                    // 令牌不足，等定时器到期再发送剩下的数据包
+                    _pacing_timer.arm(_pacer.delay_us(bytes));
+                    break;
+                }
+                _datagram_adapter.write(seg);
                 outgoing_segments_.pop();
             }
         },
-        [&] { return not outgoing_segments_.empty(); });
+        [&] {
+            return not outgoing_segments_.empty() and
+                   not _pacing_timer.armed();
+        });
+
+    // rule 5: pacing timer expired, let rule 4 send again
+    _eventloop.add_rule(
+        "release paced segments", _pacing_timer, Direction::In,
+        [&] { _pacing_timer.drain(); },
+        [&] { return _pacing_timer.armed(); });
 }
 
 //! \brief 调用socketpair来返回一对指定type的socket
@@ -267,6 +298,9 @@ void TCPSocket<AdaptT>::listen_and_accept(const TCPConfig& c_tcp,
 
     _datagram_adapter.config_mut() = c_ad;
     _datagram_adapter.set_listening(true);
+    if (c_tcp.syn_cookies) {
+        _syn_cookies.emplace(c_tcp);
+    }
 
     cerr << "\033[1;32mListening for incoming connection...\n\033[0m";
     _tcp_loop([&] {
@@ -279,6 +313,36 @@ void TCPSocket<AdaptT>::listen_and_accept(const TCPConfig& c_tcp,
     _tcp_thread = thread(&TCPSocket::_tcp_main, this);
 }
 
+template <typename AdaptT>
+void TCPSocket<AdaptT>::_cookie_handshake() {
+    auto flow = _datagram_adapter.read_flow();
+    if (not flow) {
+        return;
+    }
+    const auto& [tuple, seg] = flow.value();
+    const Address& local = _datagram_adapter.config().source;
+    const uint32_t address = local.ipv4_numeric();
+    if (tuple.local_port != local.port() or
+        (address and address != tuple.local_address)) {
+        return;
+    }
+
+    if (seg.sender_message.SYN) {
+        if (not seg.reset and not seg.receiver_message.ackno) {
+            auto syn_ack = _syn_cookies->syn_ack(tuple, seg, timestamp_ms());
+            _datagram_adapter.write(syn_ack, tuple.addresses());
+        }
+        return;
+    }
+    if (auto tcp = _syn_cookies->accept(tuple, std::move(flow->second),
+                                        timestamp_ms())) {
+        // 只有确认了有效 cookie 的对端才能占用这个监听 socket
+        _tcp = std::move(tcp);
+        _datagram_adapter.accept_flow(tuple);
+        collect_segments();
+    }
+}
+
 template <typename AdaptT>
 void TCPSocket<AdaptT>::_tcp_main() {
     try {
@@ -287,6 +351,7 @@ void TCPSocket<AdaptT>::_tcp_main() {
         }
         _tcp_loop([] { return true; });
         shutdown(SHUT_RDWR);
+        _final_stats = _tcp->stats();
         if (not _tcp.value().active()) {
             if (_tcp->inbound_reader().has_error()) {
                 cerr << "\033[1;31mDEBUG: TCP connection finished "
@@ -319,7 +384,9 @@ template class TCPSocket<TCPOverIPv4OverTunFdAdapter>;
 
 B_TCPSocketEpoll::B_TCPSocketEpoll(const std::string& devname)
     : TCPSocket<TCPOverIPv4OverTunFdAdapter>(
-          TCPOverIPv4OverTunFdAdapter(TunFD(devname)),
+          // tun.sh 创建的是多队列设备，打开模式须与设备一致；只打开一个队列
+          TCPOverIPv4OverTunFdAdapter(
+              TunFD(devname, TunFD::is_multi_queue(devname))),
           EventEpoll()) {}
 
 void B_TCPSocketEpoll::connect(const Address& address) {
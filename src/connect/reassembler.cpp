@@ -1,5 +1,7 @@
 #include "connect/reassembler.h"
 
+#include <algorithm>
+
 void Reassembler::insert(uint64_t first_index, std::string data,
                          bool is_last_substring, Writer& output) {
   if (output.is_closed()) {
@@ -55,6 +57,7 @@ void Reassembler::insert(uint64_t first_index, std::string data,
     return;
   }
 
+  _last_inserted_index = first_index;
   if (first_index + data.size() - output.bytes_pushed() <=
       output.available_capacity()) {
     _unassembled_strings[first_index] = std::move(data);
@@ -64,6 +67,18 @@ void Reassembler::insert(uint64_t first_index, std::string data,
   }
 }
 
+bool Reassembler::push_in_order(uint64_t first_index, const Buffer& data,
+                                Writer& output) {
+  if (!_unassembled_strings.empty() || output.is_closed() ||
+      first_index != output.bytes_pushed() ||
+      data.size() > output.available_capacity()) {
+    return false;
+  }
+  output.push(data);
+  _last_popped_end = output.bytes_pushed();
+  return true;
+}
+
 uint64_t Reassembler::bytes_pending() const {
   size_t res{};
   size_t prev_end = _last_popped_end;
@@ -81,23 +96,61 @@ uint64_t Reassembler::bytes_pending() const {
   return res;
 }
 
+std::vector<std::pair<uint64_t, uint64_t>> Reassembler::pending_ranges(
+    size_t max_ranges) const {
+  std::vector<std::pair<uint64_t, uint64_t>> merged;
+  for (const auto& it : _unassembled_strings) {
+    const uint64_t first = std::max(it.first, _last_popped_end);
+    const uint64_t last = it.first + it.second.size();
+    if (first >= last) {
+      continue;
+    }
+    if (!merged.empty() && first <= merged.back().second) {
+      merged.back().second = std::max(merged.back().second, last);
+    } else {
+      merged.emplace_back(first, last);
+    }
+  }
+
+  // 把包含最近插入数据的区间移到最前
+  auto recent = std::find_if(merged.begin(), merged.end(), [&](const auto& r) {
+    return r.first <= _last_inserted_index && _last_inserted_index < r.second;
+  });
+  if (recent != merged.end()) {
+    std::rotate(merged.begin(), recent, recent + 1);
+  }
+
+  if (merged.size() > max_ranges) {
+    merged.resize(max_ranges);
+  }
+  return merged;
+}
+
 void Reassembler::_push_availables(Writer& output, size_t index) {
   if (index > output.bytes_pushed()) {
     return;
   }
   size_t prev_end = _last_popped_end;
-  for (const auto& it : _unassembled_strings) {
-    if (it.first > output.bytes_pushed()) {
+  for (auto it = _unassembled_strings.begin();
+       it != _unassembled_strings.end();) {
+    const auto& [first, data] = *it;
+    if (first > output.bytes_pushed()) {
       break;
     }
-    if (it.first >= prev_end) {
-      prev_end += it.second.size();
-      output.push(it.second);
+    if (first >= prev_end) {
+      prev_end += data.size();
+      output.push(data);
     } else {
-      if (it.first + it.second.size() > prev_end) {
-        output.push(it.second.substr(prev_end - it.first));
+      if (first + data.size() > prev_end) {
+        output.push(data.substr(prev_end - first));
       }
-      prev_end = std::max(prev_end, it.first + it.second.size());
+      prev_end = std::max(prev_end, first + data.size());
+    }
+    // 已经全部提交的数据不再保留
+    if (first + data.size() <= output.bytes_pushed()) {
+      it = _unassembled_strings.erase(it);
+    } else {
+      ++it;
     }
   }
   _last_popped_end = output.bytes_pushed();
@@ -0,0 +1,149 @@
+#include "connect/syn_cookie.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <random>
+#include <utility>
+
+using namespace std;
+
+/* cookie 的布局 (高位到低位)：5 位时间，23 位哈希，
+   1 位 SACK-Permitted，3 位 MSS 在 MSS_TABLE 中的下标 */
+static constexpr unsigned COUNT_SHIFT = 27;
+static constexpr unsigned HASH_SHIFT = 4;
+static constexpr uint32_t HASH_MASK = (1U << (COUNT_SHIFT - HASH_SHIFT)) - 1;
+static constexpr uint32_t COUNT_MASK = (1U << (32 - COUNT_SHIFT)) - 1;
+static constexpr uint32_t OPTIONS_MASK = (1U << HASH_SHIFT) - 1;
+static constexpr uint32_t SACK_BIT = 1U << 3;
+
+//! 还原的 MSS 只能是其中之一：取不超过对端 MSS 的最大值
+static constexpr array<uint16_t, 8> MSS_TABLE = {536,  1024, 1200, 1300,
+                                                 1360, 1400, 1440, 1460};
+
+static void sip_round(array<uint64_t, 4>& v) {
+    v[0] += v[1];
+    v[1] = rotl(v[1], 13) ^ v[0];
+    v[0] = rotl(v[0], 32);
+    v[2] += v[3];
+    v[3] = rotl(v[3], 16) ^ v[2];
+    v[0] += v[3];
+    v[3] = rotl(v[3], 21) ^ v[0];
+    v[2] += v[1];
+    v[1] = rotl(v[1], 17) ^ v[2];
+    v[2] = rotl(v[2], 32);
+}
+
+//! SipHash-2-4，输入为整数个 64 位的字
+template <size_t N>
+static uint64_t siphash(const array<uint64_t, 2>& key,
+                        const array<uint64_t, N>& words) {
+    array<uint64_t, 4> v = {key[0] ^ 0x736f6d6570736575ULL,
+                            key[1] ^ 0x646f72616e646f6dULL,
+                            key[0] ^ 0x6c7967656e657261ULL,
+                            key[1] ^ 0x7465646279746573ULL};
+    const auto compress = [&](const uint64_t m) {
+        v[3] ^= m;
+        sip_round(v);
+        sip_round(v);
+        v[0] ^= m;
+    };
+    for (const uint64_t m : words) {
+        compress(m);
+    }
+    compress(uint64_t{N * 8} << 56);
+    v[2] ^= 0xff;
+    for (int i = 0; i < 4; i++) {
+        sip_round(v);
+    }
+    return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
+//! 32 位序列号的原始值
+static uint32_t raw(const Wrap32 seqno) {
+    return static_cast<uint32_t>(seqno.unwrap(Wrap32{0}, 0));
+}
+
+SynCookies::SynCookies(const TCPConfig& cfg) : _cfg(cfg) {
+    random_device rd;
+    for (auto& word : _key) {
+        word = (uint64_t{rd()} << 32) | rd();
+    }
+}
+
+uint32_t SynCookies::hash(const FourTuple& tuple, const Wrap32 peer_isn,
+                          const uint32_t count,
+                          const uint32_t options) const {
+    const array<uint64_t, 3> words = {
+        (uint64_t{tuple.local_address} << 32) | tuple.remote_address,
+        (uint64_t{tuple.local_port} << 48) |
+            (uint64_t{tuple.remote_port} << 32) | raw(peer_isn),
+        (uint64_t{count} << 32) | options};
+    return static_cast<uint32_t>(siphash(_key, words)) & HASH_MASK;
+}
+
+TCPEndpoint SynCookies::restore(const Wrap32 peer_isn,
+                                const uint32_t cookie) const {
+    TCPConfig cfg = _cfg;
+    cfg.fixed_isn = Wrap32{cookie};
+    TCPEndpoint tcp(cfg);
+
+    // 窗口扩大与时间戳选项无处保存，还原的 SYN 不带它们，
+    // 于是 SYN-ACK 也不带，双方都不使用
+    TCPSegment syn;
+    syn.sender_message = {.seqno = peer_isn,
+                          .SYN = true,
+                          .mss = MSS_TABLE.at(cookie % MSS_TABLE.size()),
+                          .sack_permitted = (cookie & SACK_BIT) != 0};
+    tcp.receive(std::move(syn));
+    return tcp;
+}
+
+TCPSegment SynCookies::syn_ack(const FourTuple& tuple, const TCPSegment& syn,
+                               const uint64_t now_ms) const {
+    const TCPSenderMessage& msg = syn.sender_message;
+    const uint16_t peer_mss = msg.mss.value_or(TCPConfig::DEFAULT_PEER_MSS);
+    const auto larger =
+        upper_bound(MSS_TABLE.begin(), MSS_TABLE.end(), peer_mss);
+    const auto index = static_cast<uint32_t>(
+        max(distance(MSS_TABLE.begin(), larger) - 1, ptrdiff_t{0}));
+    const uint32_t options = (msg.sack_permitted ? SACK_BIT : 0) | index;
+
+    const auto count =
+        static_cast<uint32_t>(now_ms / TCPConfig::SYN_COOKIE_PERIOD_MS);
+    const uint32_t cookie = ((count & COUNT_MASK) << COUNT_SHIFT) |
+                            (hash(tuple, msg.seqno, count, options)
+                             << HASH_SHIFT) |
+                            options;
+
+    // 连接只为生成 SYN-ACK 而构造，随即丢弃
+    return restore(msg.seqno, cookie).maybe_send().value();
+}
+
+optional<TCPEndpoint> SynCookies::accept(const FourTuple& tuple,
+                                         TCPSegment ack,
+                                         const uint64_t now_ms) const {
+    if (ack.reset or ack.sender_message.SYN or
+        not ack.receiver_message.ackno) {
+        return {};
+    }
+    const uint32_t cookie = raw(ack.receiver_message.ackno.value()) - 1;
+    const Wrap32 peer_isn = ack.sender_message.seqno + UINT32_MAX;
+    const uint32_t options = cookie & OPTIONS_MASK;
+
+    const auto now_count =
+        static_cast<uint32_t>(now_ms / TCPConfig::SYN_COOKIE_PERIOD_MS);
+    for (const uint32_t age : {0U, 1U}) {
+        const uint32_t count = now_count - age;
+        if ((count & COUNT_MASK) != cookie >> COUNT_SHIFT or
+            hash(tuple, peer_isn, count, options) !=
+                ((cookie >> HASH_SHIFT) & HASH_MASK)) {
+            continue;
+        }
+        TCPEndpoint tcp = restore(peer_isn, cookie);
+        tcp.assume_syn_ack_sent();
+        tcp.receive(std::move(ack));
+        return tcp;
+    }
+    return {};
+}
@@ -0,0 +1,661 @@
+#include "connect/tcp_stack.h"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "utils/exception.h"
+
+using namespace std;
+
+static constexpr size_t TCP_TICK_MS = 10;
+static constexpr size_t RECV_BATCH = 64;  //!< 每次事件最多读取的数据包
+static constexpr size_t SOCKET_BATCH = 64;  //!< 每次事件最多服务的连接
+
+static inline uint64_t timestamp_ms() {
+    return std::chrono::steady_clock::now().time_since_epoch().count() /
+           1000000;
+}
+
+static inline uint64_t timestamp_us() {
+    return std::chrono::steady_clock::now().time_since_epoch().count() / 1000;
+}
+
+//! \brief 调用socketpair来返回一对指定type的socket
+static inline pair<FileDescriptor, FileDescriptor> socket_pair_helper(
+    const int type) {
+    array<int, 2> fds{};
+    CheckSystemCall("socketpair", ::socketpair(AF_UNIX, type, 0, fds.data()));
+    return {FileDescriptor(fds[0]), FileDescriptor(fds[1])};
+}
+
+TCPStackSocket::TCPStackSocket(Socket&& app_side,
+                               shared_future<void> closed)
+    : Socket(std::move(app_side)), _closed(std::move(closed)) {}
+
+void TCPStackSocket::wait_until_closed() {
+    shutdown(SHUT_RDWR);
+    _closed.wait();
+}
+
+TCPStackSocket TCPStackListener::accept() {
+    unique_lock lock(_queue->mutex);
+    _queue->ready.wait(lock, [&] {
+        return _queue->closed or not _queue->established.empty();
+    });
+    if (_queue->established.empty()) {
+        throw runtime_error("accept() on a closed listener");
+    }
+    TCPStackSocket socket = std::move(_queue->established.front());
+    _queue->established.pop_front();
+    return socket;
+}
+
+void TCPStackListener::close() {
+    if (not _queue) {
+        return;
+    }
+    const lock_guard lock(_queue->mutex);
+    _queue->closed = true;
+    _queue->established.clear();
+    _queue->ready.notify_all();
+}
+
+//! \param[in] devname 所有连接共用的 tun 设备
+//! \param[in] shards 分片 (线程) 数，单队列的 tun 上只使用一个
+//! \param[in] offload 是否启用 tun 的校验和与 TSO 卸载
+TCPStack::TCPStack(const string& devname, const size_t shards,
+                   const bool offload) {
+    // 每个分片打开 tun 的一个队列，内核按流分发。单队列的 tun 无法按流
+    // 分发，多个分片只能由一个分片读取全部报文再转交，数据路径上的转交
+    // 抵消了分片的收益，因此只使用一个分片
+    _multi_queue = TunFD::is_multi_queue(devname);
+    size_t count = max(shards, size_t{1});
+    if (count > 1 and not _multi_queue) {
+        cerr << "WARNING: " << devname << " is not a multi-queue tun device, "
+             << "running 1 shard instead of " << count << "\n";
+        count = 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        _shards.push_back(
+            make_unique<Shard>(i, TunFD(devname, _multi_queue, offload)));
+    }
+    for (auto& shard : _shards) {
+        for (size_t i = 0; i < _shards.size(); i++) {
+            shard->inbox.push_back(
+                make_unique<SpscQueue<Flow>>(STEER_QUEUE_SIZE));
+        }
+        _setup_shard(*shard);
+    }
+    for (auto& shard : _shards) {
+        shard->thread = thread(&TCPStack::_shard_main, this, ref(*shard));
+    }
+}
+
+void TCPStack::_setup_shard(Shard& shard) {
+    EventEpoll& loop = shard.eventloop;
+
+    shard.adapter.fd().set_blocking(false);
+    loop.add_rule("receive TCP segment from the network", shard.adapter.fd(),
+                  Direction::In, [&] { _receive_batch(shard); });
+
+    loop.add_rule(
+        "receive steered TCP segments", shard.wakeup, Direction::In,
+        [&] {
+            shard.wakeup.drain();
+            for (auto& queue : shard.inbox) {
+                while (auto flow = queue->pop()) {
+                    _deliver(shard, std::move(flow.value()));
+                }
+            }
+        });
+
+    loop.add_rule("serve connection sockets", shard.sockets, Direction::In,
+                  [&] { _serve_sockets(shard); });
+
+    loop.add_rule(
+        "send TCP segment", shard.adapter.fd(), Direction::Out,
+        [&] { _send_segments(shard); },
+        [&] {
+            return not shard.senders.empty() and
+                   not shard.pacing_timer.armed();
+        });
+
+    loop.add_rule(
+        "release paced segments", shard.pacing_timer, Direction::In,
+        [&] { shard.pacing_timer.drain(); },
+        [&] { return shard.pacing_timer.armed(); });
+
+    loop.add_rule(
+        "register new connections",
+        [&] {
+            vector<unique_ptr<Connection>> pending;
+            {
+                const lock_guard lock(shard.pending_mutex);
+                pending.swap(shard.pending);
+                shard.has_pending = false;
+            }
+            for (auto& conn : pending) {
+                _register(shard, std::move(conn));
+            }
+        },
+        [&] { return shard.has_pending.load(); });
+}
+
+TCPStack::~TCPStack() {
+    try {
+        _abort.store(true);
+        for (auto& shard : _shards) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+    } catch (const exception& e) {
+        cerr << "Exception destructing TCPStack: " << e.what() << endl;
+    }
+}
+
+uint64_t TCPStack::steered() const {
+    uint64_t total = 0;
+    for (const auto& shard : _shards) {
+        total += shard->steered;
+    }
+    return total;
+}
+
+size_t TCPStack::shard_index(const FourTuple& tuple, const size_t shards) {
+    const uint64_t hash = FourTupleHash{}(tuple) >> 32;
+    return hash * shards >> 32;
+}
+
+void TCPStack::_receive_batch(Shard& shard) {
+    // 每次最多读取 RECV_BATCH 个，避免 tun 的队列在连接很多时溢出；
+    // 属于其他分片的报文转交出去，每批结束时各唤醒一次
+    FileDescriptor& tun = shard.adapter.fd();
+    vector<bool> woken(_shards.size());
+    for (size_t i = 0; i < RECV_BATCH; i++) {
+        const auto reads = tun.read_count();
+        auto flow = shard.adapter.read_flow();
+        if (tun.read_count() == reads) {
+            break;
+        }
+        if (not flow) {
+            continue;
+        }
+        Shard& owner = _shard_of(flow->first);
+        if (&owner == &shard) {
+            _deliver(shard, std::move(flow.value()));
+            continue;
+        }
+        if (owner.inbox[shard.index]->push(std::move(flow.value()))) {
+            shard.steered += 1;
+            woken[owner.index] = true;
+        } else {
+            shard.steer_drops += 1;
+        }
+    }
+    for (size_t i = 0; i < _shards.size(); i++) {
+        if (woken[i]) {
+            _shards[i]->wakeup.notify();
+        }
+    }
+}
+
+void TCPStack::_deliver(Shard& shard, Flow flow) {
+    auto& [tuple, seg] = flow;
+    const auto it = shard.connections.find(tuple);
+    if (it == shard.connections.end()) {
+        // 不属于任何连接：可能是新连接的 SYN 或确认 cookie 的 ACK
+        if (seg.reset) {
+            return;
+        }
+        if (not seg.sender_message.SYN) {
+            _accept_cookie(shard, tuple, std::move(seg));
+        } else if (not seg.receiver_message.ackno) {
+            _accept_syn(shard, tuple, std::move(seg));
+        }
+        return;
+    }
+    Connection& conn = *it->second;
+    _advance(conn, timestamp_ms());
+    conn.tcp.receive(std::move(seg));
+    _touch(shard, conn);
+}
+
+pair<unique_ptr<TCPStack::Connection>, TCPStackSocket>
+TCPStack::_make_connection(const TCPConfig& c_tcp,
+                           const FdAdapterConfig& c_ad) {
+    auto [app_side, stack_side] = socket_pair_helper(SOCK_STREAM);
+    Socket app(std::move(app_side), AF_UNIX, SOCK_STREAM);
+    app.set_blocking(false);
+
+    auto conn = make_unique<Connection>(
+        c_tcp, c_ad, Socket(std::move(stack_side), AF_UNIX, SOCK_STREAM));
+    conn->data.set_blocking(false);
+    TCPStackSocket socket(std::move(app), conn->closed.get_future().share());
+    return {std::move(conn), std::move(socket)};
+}
+
+TCPStackSocket TCPStack::connect(const TCPConfig& c_tcp,
+                                 const FdAdapterConfig& c_ad) {
+    auto [conn, socket] = _make_connection(c_tcp, c_ad);
+    // 连接只在建立时交给所属的分片
+    Shard& shard = _shard_of(FourTuple::of(c_ad));
+    {
+        const lock_guard lock(shard.pending_mutex);
+        shard.pending.push_back(std::move(conn));
+        shard.has_pending = true;
+    }
+    // 立即唤醒分片发出 SYN，而不是等到下一次 tick
+    shard.wakeup.notify();
+    return std::move(socket);
+}
+
+TCPStackListener TCPStack::listen(const TCPConfig& c_tcp,
+                                  const Address& local,
+                                  const size_t backlog) {
+    auto queue = make_shared<ListenQueue>(c_tcp, local.ipv4_numeric(),
+                                          max(backlog, size_t{1}));
+    if (c_tcp.syn_cookies) {
+        queue->cookies.emplace(c_tcp);
+    }
+    const lock_guard lock(_listeners_mutex);
+    const auto it = _listeners.find(local.port());
+    if (it != _listeners.end() and not it->second->closed) {
+        throw runtime_error("port " + to_string(local.port()) +
+                            " is already listening");
+    }
+    _listeners.insert_or_assign(local.port(), queue);
+    return TCPStackListener(std::move(queue));
+}
+
+shared_ptr<ListenQueue> TCPStack::_find_listener(const FourTuple& tuple) {
+    shared_ptr<ListenQueue> listener;
+    {
+        const lock_guard lock(_listeners_mutex);
+        const auto it = _listeners.find(tuple.local_port);
+        if (it == _listeners.end()) {
+            return {};
+        }
+        if (it->second->closed) {
+            _listeners.erase(it);
+            return {};
+        }
+        listener = it->second;
+    }
+    if (listener->address and listener->address != tuple.local_address) {
+        return {};
+    }
+    return listener;
+}
+
+bool ListenQueue::accept_queue_full() {
+    const lock_guard lock(mutex);
+    return established.size() >= backlog;
+}
+
+bool ListenQueue::admit_syn() {
+    if (accept_queue_full()) {
+        syns_dropped += 1;
+        return false;
+    }
+    // 使用 cookie 时没有半连接队列；各分片可能同时收到 SYN，
+    // 先占用位置，超出上限时退回
+    if (not cookies and syn_received.fetch_add(1) >= backlog) {
+        syn_received -= 1;
+        syns_dropped += 1;
+        return false;
+    }
+    return true;
+}
+
+void TCPStack::_accept_syn(Shard& shard, const FourTuple& tuple,
+                           TCPSegment syn) {
+    const auto listener = _find_listener(tuple);
+    if (not listener) {
+        return;
+    }
+
+    if (not listener->admit_syn()) {
+        return;
+    }
+
+    if (listener->cookies) {
+        auto syn_ack = listener->cookies->syn_ack(tuple, syn, timestamp_ms());
+        shard.adapter.write(syn_ack, tuple.addresses());
+        return;
+    }
+
+    auto [conn, socket] = _make_connection(listener->cfg, tuple.addresses());
+    conn->listener = listener;
+    conn->app.emplace(std::move(socket));
+    _register(shard, std::move(conn), std::move(syn));
+}
+
+void TCPStack::_accept_cookie(Shard& shard, const FourTuple& tuple,
+                              TCPSegment ack) {
+    const auto listener = _find_listener(tuple);
+    if (not listener or not listener->cookies or
+        listener->accept_queue_full()) {
+        return;
+    }
+
+    auto tcp =
+        listener->cookies->accept(tuple, std::move(ack), timestamp_ms());
+    if (not tcp) {
+        listener->cookies_rejected += 1;
+        return;
+    }
+
+    auto [conn, socket] = _make_connection(listener->cfg, tuple.addresses());
+    conn->tcp = std::move(tcp.value());
+    conn->listener = listener;
+    conn->app.emplace(std::move(socket));
+    listener->syn_received += 1;
+    _register(shard, std::move(conn));
+}
+
+void TCPStack::_check_established(Connection& conn) {
+    if (not conn.tcp.has_ackno() or
+        conn.tcp.transceiver().sequence_numbers_in_flight()) {
+        return;
+    }
+    const auto listener = std::move(conn.listener);
+    conn.listener.reset();
+    listener->syn_received -= 1;
+    {
+        // 监听已关闭时应用一端随之关闭，连接正常结束
+        const lock_guard lock(listener->mutex);
+        if (not listener->closed) {
+            listener->established.push_back(std::move(conn.app.value()));
+        }
+    }
+    conn.app.reset();
+    listener->ready.notify_one();
+}
+
+void TCPStack::_register(Shard& shard, unique_ptr<Connection> conn,
+                         optional<TCPSegment> syn) {
+    const auto tuple = FourTuple::of(conn->addresses);
+    if (shard.connections.contains(tuple)) {
+        // 栈的一端随 conn 关闭，应用读到 EOF
+        cerr << "ERROR: Connection to "
+             << conn->addresses.destination.to_string() << " from port "
+             << conn->addresses.source.port() << " already exists.\n";
+        conn->closed.set_value();
+        return;
+    }
+
+    Connection& c = *conn;
+    shard.connections.emplace(tuple, std::move(conn));
+    _connection_count += 1;
+    c.last_tick_ms = timestamp_ms();
+
+    if (syn) {
+        c.tcp.receive(std::move(syn.value()));
+    } else {
+        c.tcp.push();
+    }
+    _touch(shard, c);
+}
+
+void TCPStack::_advance(Connection& conn, const uint64_t now_ms) {
+    if (now_ms > conn.last_tick_ms) {
+        conn.tcp.tick(now_ms - conn.last_tick_ms);
+        conn.last_tick_ms = now_ms;
+    }
+}
+
+void TCPStack::_touch(Shard& shard, Connection& conn) {
+    _collect_segments(shard, conn);
+    if (conn.listener) {
+        _check_established(conn);
+    }
+    _watch(shard, conn);
+    _schedule(shard, conn);
+    _mark_touched(shard, conn);
+}
+
+void TCPStack::_mark_touched(Shard& shard, Connection& conn) {
+    if (not conn.touched) {
+        conn.touched = true;
+        shard.touched.push_back(&conn);
+    }
+}
+
+void TCPStack::_watch(Shard& shard, Connection& conn) {
+    uint32_t events = 0;
+    if (conn.tcp.active() and not conn.outbound_shutdown and
+        conn.tcp.outbound_writer().available_capacity() > 0) {
+        events |= EPOLLIN;
+    }
+    const Reader& inbound = conn.tcp.inbound_reader();
+    if (not conn.inbound_shutdown and
+        (inbound.bytes_buffered() or inbound.is_finished() or
+         inbound.has_error())) {
+        events |= EPOLLOUT;
+    }
+    // 挂断后 EPOLLHUP 一直就绪，没有关注的事件时移出 epoll，
+    // 关注的事件再次出现时 (如窗口打开后继续读取) 重新加入
+    const bool watch =
+        events or not(conn.hung_up or
+                      (conn.inbound_shutdown and conn.outbound_shutdown));
+    if (watch != conn.watched) {
+        if (watch) {
+            shard.sockets.add(conn.data, events, &conn);
+        } else {
+            shard.sockets.remove(conn.data);
+        }
+        conn.watched = watch;
+    } else if (watch and events != conn.events) {
+        shard.sockets.modify(conn.data, events, &conn);
+    }
+    conn.events = events;
+}
+
+void TCPStack::_schedule(Shard& shard, Connection& conn) {
+    const auto timeout = conn.tcp.next_timeout_ms();
+    if (not timeout) {
+        return;
+    }
+    // 至少等待 1 ms，已到期却暂时无事可做的计时器 (如窗口不足时的 cork)
+    // 不会在同一毫秒内反复触发
+    const uint64_t deadline =
+        conn.last_tick_ms + max(timeout.value(), uint64_t{1});
+    // 堆中已有更早的项时不再加入，它到期时重新计算
+    if (conn.deadline_ms and conn.deadline_ms.value() <= deadline) {
+        return;
+    }
+    conn.deadline_ms = deadline;
+    shard.timers.push({deadline, FourTuple::of(conn.addresses)});
+}
+
+void TCPStack::_expire_timers(Shard& shard, const uint64_t now_ms) {
+    while (not shard.timers.empty() and
+           shard.timers.top().deadline_ms <= now_ms) {
+        const Timer timer = shard.timers.top();
+        shard.timers.pop();
+        const auto it = shard.connections.find(timer.tuple);
+        if (it == shard.connections.end() or
+            it->second->deadline_ms != timer.deadline_ms) {
+            continue;
+        }
+        Connection& conn = *it->second;
+        conn.deadline_ms.reset();
+        _advance(conn, now_ms);
+        _touch(shard, conn);
+    }
+}
+
+void TCPStack::_serve_sockets(Shard& shard) {
+    const auto now = timestamp_ms();
+    for (const auto& event : shard.sockets.wait(SOCKET_BATCH)) {
+        Connection& conn = *static_cast<Connection*>(event.data.ptr);
+        _advance(conn, now);
+        const uint32_t ready = event.events & conn.events;
+        if (event.events & EPOLLERR) {
+            // 出错的 socket 不再读写
+            conn.tcp.outbound_writer().close();
+            conn.outbound_shutdown = true;
+            conn.inbound_shutdown = true;
+            conn.hung_up = true;
+        } else {
+            if (ready & EPOLLIN) {
+                _pull_from_app(conn);
+            }
+            if (ready & EPOLLOUT) {
+                _push_to_app(conn);
+            }
+            if (event.events & EPOLLHUP) {
+                // 不能再写给应用；关注读事件却不可读时，也不会再有数据
+                conn.inbound_shutdown = true;
+                conn.hung_up = true;
+                if ((conn.events & EPOLLIN) and not(ready & EPOLLIN)) {
+                    conn.tcp.outbound_writer().close();
+                    conn.outbound_shutdown = true;
+                }
+            }
+        }
+        _touch(shard, conn);
+    }
+}
+
+void TCPStack::_pull_from_app(Connection& conn) {
+    string data;
+    data.resize(conn.tcp.outbound_writer().available_capacity());
+    conn.data.read(data);
+    conn.tcp.outbound_writer().push(std::move(data));
+    if (conn.data.eof()) {
+        conn.tcp.outbound_writer().close();
+        conn.outbound_shutdown = true;
+    }
+    conn.tcp.push();
+}
+
+void TCPStack::_push_to_app(Connection& conn) {
+    // 读出的数据腾出了窗口，_touch 中必要时发送窗口更新
+    Reader& inbound = conn.tcp.inbound_reader();
+    if (inbound.bytes_buffered()) {
+        inbound.pop(conn.data.write(inbound.peek()));
+    }
+    if (inbound.is_finished() or inbound.has_error()) {
+        conn.data.shutdown(SHUT_WR);
+        conn.inbound_shutdown = true;
+    }
+}
+
+void TCPStack::_reap(Shard& shard) {
+    // 连接只在状态变化时才可能结束，不必遍历所有连接
+    for (Connection* conn : shard.touched) {
+        conn->touched = false;
+        if (conn->listener) {
+            // 握手失败 (被重置或 SYN-ACK 重传次数过多) 的半连接
+            if (not conn->tcp.inbound_reader().has_error() and
+                conn->tcp.transceiver().consecutive_retransmissions() <=
+                    TCPConfig::MAX_RETX_ATTEMPTS) {
+                continue;
+            }
+            conn->listener->syn_received -= 1;
+            erase(shard.senders, conn);
+        } else if (conn->tcp.active() or conn->sending or
+                   not conn->inbound_shutdown) {
+            continue;
+        }
+        if (conn->watched) {
+            shard.sockets.remove(conn->data);
+        }
+        conn->closed.set_value();
+        _connection_count -= 1;
+        shard.connections.erase(FourTuple::of(conn->addresses));
+    }
+    shard.touched.clear();
+}
+
+void TCPStack::_collect_segments(Shard& shard, Connection& conn) {
+    while (auto seg = conn.tcp.maybe_send()) {
+        conn.outgoing.push(std::move(seg.value()));
+    }
+    if (not conn.outgoing.empty() and not conn.sending) {
+        conn.sending = true;
+        shard.senders.push_back(&conn);
+    }
+}
+
+void TCPStack::_send_segments(Shard& shard) {
+    const auto now = timestamp_us();
+    optional<uint64_t> delay;
+    erase_if(shard.senders, [&](Connection* conn) {
+        const auto& transceiver = conn->tcp.transceiver();
+        conn->pacer.set_rate(now, transceiver.pacing_rate(),
+                             transceiver.pacing_burst());
+        // 令牌允许的报文一起交给适配器，启用卸载时合并为超级报文
+        vector<TCPSegment> batch;
+        bool paced = false;
+        while (not conn->outgoing.empty()) {
+            auto& seg = conn->outgoing.front();
+            const auto bytes = IPv4Header::LENGTH + seg.header_length() +
+                               seg.sender_message.payload.size();
+            if (not conn->pacer.try_send(now, bytes)) {
+                const uint64_t wait = conn->pacer.delay_us(bytes);
+                delay = min(delay.value_or(wait), wait);
+                paced = true;
+                break;
+            }
+            batch.push_back(std::move(seg));
+            conn->outgoing.pop();
+        }
+        // 第一个报文就被限速时没有可写的报文，不必进入适配器
+        if (not batch.empty()) {
+            shard.adapter.write(batch, conn->addresses);
+        }
+        if (paced) {
+            return false;
+        }
+        conn->sending = false;
+        _mark_touched(shard, *conn);
+        return true;
+    });
+    if (delay) {
+        shard.pacing_timer.arm(delay.value());
+    }
+}
+
+void TCPStack::_shard_main(Shard& shard) {
+    try {
+        auto base_time = timestamp_ms();
+        while (not _abort) {
+            // 等到最近的计时器到期，最长 TCP_TICK_MS 以便及时退出
+            uint64_t timeout = TCP_TICK_MS;
+            if (not shard.timers.empty()) {
+                const uint64_t deadline = shard.timers.top().deadline_ms;
+                timeout = min(timeout, deadline - min(deadline, base_time));
+            }
+            shard.eventloop.wait_next_event(static_cast<int>(timeout));
+
+            const auto next_time = timestamp_ms();
+            _expire_timers(shard, next_time);
+            shard.adapter.tick(next_time - base_time);
+            base_time = next_time;
+            _reap(shard);
+        }
+    } catch (const exception& e) {
+        cerr << "\033[1;31mException in TCPStack shard " << shard.index
+             << ": " << e.what() << "\n\033[0m";
+    }
+
+    // 栈停止后，等待中的应用不再阻塞
+    for (auto& [tuple, conn] : shard.connections) {
+        conn->closed.set_value();
+    }
+    const lock_guard lock(shard.pending_mutex);
+    for (auto& conn : shard.pending) {
+        conn->closed.set_value();
+    }
+}
@@ -0,0 +1,33 @@
+#include "connect/tcp_stats.h"
+
+#include <sstream>
+
+using namespace std;
+
+string TCPStats::to_string() const {
+  stringstream ss;
+  ss << "cc=" << congestion_control << ", cwnd=" << cwnd;
+  if (ssthresh != UINT64_MAX) {
+    ss << ", ssthresh=" << ssthresh;
+  }
+  ss << ", pacing_rate=" << pacing_rate * 8 / 1000 << " kbit/s"
+     << ", pacing_burst=" << pacing_burst
+     << ", delivery_rate=" << delivery_rate * 8 / 1000 << " kbit/s";
+  if (min_rtt_ms) {
+    ss << ", min_rtt=" << min_rtt_ms.value() << " ms";
+  }
+  if (srtt_ms) {
+    ss << ", srtt=" << srtt_ms.value() << " ms, rttvar=" << rttvar_ms
+       << " ms";
+  }
+  ss << ", rto=" << rto_ms << " ms";
+  ss << ", delivered=" << bytes_delivered
+     << ", retransmitted=" << segments_retransmitted
+     << ", loss_probes=" << loss_probes << ", mss=" << mss
+     << ", mtu_probes=" << mtu_probes << ", window_probes=" << window_probes
+     << ", acks_saved=" << acks_saved
+     << ", rcv_buffer=" << rcv_buffer << ", snd_buffer=" << snd_buffer
+     << ", predicted=" << header_predicted
+     << "/" << segments_received;
+  return ss.str();
+}
@@ -6,15 +6,49 @@
 #include "config/tcp_config.h"
 #include "datagram/tcp_message.h"
 
-Transceiver::Transceiver(uint64_t initial_RTO_ms,
-                         std::optional<Wrap32> fixed_isn)
-    : send_isn_(fixed_isn.value_or(Wrap32{std::random_device()()})),
-      initial_RTO_ms_(initial_RTO_ms) {}
+//! 时间戳选项在每个报文中占用的空间 (含两个 NOP)
+static constexpr uint64_t TIMESTAMP_OPTION_SPACE = 12;
 
-uint64_t Transceiver::sequence_numbers_in_flight() const {
+//! 携带 blocks 个块的 SACK 选项占用的空间 (含两个 NOP)
+static constexpr uint64_t sack_option_space(size_t blocks) {
+    return blocks ? 4 + 8 * blocks : 0;
+}
+
+Transceiver::Transceiver(const TCPConfig& cfg)
+    : cfg_(cfg),
+      // value_or 总会构造 random_device (一次系统调用)，只在需要时构造
+      send_isn_(cfg.fixed_isn ? cfg.fixed_isn.value()
+                              : Wrap32{std::random_device()()}),
+      rtt_(cfg.rt_timeout, cfg.min_rto, cfg.max_rto,
+           TCPConfig::CLOCK_GRANULARITY),
+      _mss(std::max(cfg.mss, TCPConfig::MIN_MSS)),
+      cc_(make_congestion_control(cfg, _mss)) {
+    // 能通告完整接收缓冲区的最小因子；缓冲区会自动增长时按上限计算
+    const uint64_t max_window =
+        std::max(cfg_.recv_capacity,
+                 cfg_.rcvbuf_autotune ? cfg_.max_recv_capacity : 0);
+    while (_rcv_window_shift < TCPConfig::MAX_WINDOW_SHIFT &&
+           (max_window >> _rcv_window_shift) > UINT16_MAX) {
+        _rcv_window_shift += 1;
+    }
+}
+
+uint64_t Transceiver::pipe() const {
+    // 只有恢复中才有丢失或重传过的报文
+    if (!_recovery_point) {
+        return _seqnos_in_flight - _sacked_seqnos;
+    }
     uint64_t res{};
-    for (const auto& it : _messages) {
-        res += it.second.sequence_length();
+    for (const auto& seg : _messages) {
+        if (seg.sacked) {
+            continue;
+        }
+        if (!seg.lost) {
+            res += seg.message.sequence_length();
+        }
+        if (seg.retransmitted) {
+            res += seg.message.sequence_length();
+        }
     }
     return res;
 }
@@ -24,107 +58,743 @@ uint64_t Transceiver::consecutive_retransmissions() const {
 }
 
 std::optional<TCPSenderMessage> Transceiver::maybe_send() {
-    if (!isn_send_queue_.empty()) {
-        uint64_t seqno = isn_send_queue_.front();
-        isn_send_queue_.pop();
-        if (const auto& msg = _messages.find(seqno); msg != _messages.end()) {
-            return msg->second;
+    // 窗口探测：不带数据，序列号为 snd.nxt - 1，对端必须回复 ACK
+    if (_window_probe_pending) {
+        _window_probe_pending = false;
+        TCPSenderMessage probe = send_empty_message();
+        probe.seqno = send_isn_ + (next_seqno() - 1);
+        return probe;
+    }
+
+    // 重传优先于新数据，按序列号从低到高
+    for (size_t i = 0; _retransmits_queued && i < _send_index; i++) {
+        auto& seg = _messages[i];
+        if (!seg.queued) {
+            continue;
         }
+        seg.queued = false;
+        _retransmits_queued -= 1;
+        // 已被 SACK 的报文无需再发送
+        if (!seg.sacked) {
+            return transmit(seg);
+        }
+    }
+
+    if (_send_index < _messages.size()) {
+        return transmit(_messages[_send_index++]);
     }
     return {};
 }
 
-void Transceiver::push(Reader& outbound_stream) {
-    using value_type = decltype(_messages)::value_type;
-    uint16_t window_size = _window_size;
-    if (!window_size && !sequence_numbers_in_flight()) {
-        window_size = 1;
+TCPSenderMessage Transceiver::transmit(OutstandingSegment& seg) {
+    const bool retransmit = seg.transmissions > 0;
+    _retransmitted_segments += retransmit;
+    seg.delivery = sampler_.on_send(
+        _time_ms, !retransmit && seg.seqno <= _last_ackno, retransmit);
+    seg.transmissions += 1;
+
+    // 被动打开时，只有对端的 SYN 带有时间戳才回应
+    const bool stamp =
+        seg.message.SYN
+            ? cfg_.timestamps && (!receive_isn_ || _peer_timestamps)
+            : timestamping();
+    TCPSenderMessage message = seg.message;
+    if (stamp) {
+        message.ts_val = ts_clock();
+    }
+    return message;
+}
+
+void Transceiver::queue_retransmit(OutstandingSegment& seg) {
+    if (!seg.queued && seg.transmissions) {
+        seg.queued = true;
+        _retransmits_queued += 1;
+    }
+}
+
+void Transceiver::push(Reader& outbound_stream, size_t sack_blocks) {
+    // 释放已被确认的数据 (FIN 不占用流中的字节)
+    const uint64_t acked_bytes =
+        std::min(_last_ackno - (_last_ackno > 0), _segmented_bytes);
+    if (acked_bytes > outbound_stream.bytes_popped()) {
+        outbound_stream.pop(acked_bytes - outbound_stream.bytes_popped());
     }
 
     if (_finished) {
         return;
     }
 
-    std::string payload;
+    // 零窗口时只有 SYN 和单独的 FIN 可以发出；有数据等待时启动持续计时器，
+    // 由窗口探测取得窗口更新 (在途的数据由重传计时器负责)
+    uint64_t window_size = _window_size;
+    const uint64_t queued = outbound_stream.bytes_buffered() -
+                            (_segmented_bytes - outbound_stream.bytes_popped());
+    if (!window_size && !sequence_numbers_in_flight()) {
+        if (_started && queued) {
+            if (!_persist_elapsed_ms) {
+                _persist_elapsed_ms = 0;
+            }
+            return;
+        }
+        window_size = 1;
+    }
 
-    while (window_size > sequence_numbers_in_flight()) {
+    // 同时受接收窗口 (相对确认号) 和拥塞窗口 (相对仍在网络中的数据) 限制，
+    // 拥塞窗口的余量不足一个 MSS 时不发送 (RFC 6675)
+    // pipe 只在进入时计算一次，之后随新报文递增
+    const uint64_t cwnd = send_window();
+    uint64_t in_network = pipe();
+    while (window_size > _seqnos_in_flight &&
+           cwnd >= in_network + _mss) {
         bool syn{};
         bool fin{};
-        uint64_t abs_seqno = 1 + outbound_stream.bytes_popped();
-        uint16_t read_size = window_size - sequence_numbers_in_flight();
-
+        const uint64_t abs_seqno = next_seqno();
+        uint64_t read_size =
+            std::min(window_size - _seqnos_in_flight, cwnd - in_network);
         if (!_started) {
             _started = true;
             syn = true;
             read_size -= 1;
-            abs_seqno -= 1;
+            // 被动打开时，只有对端的 SYN 带有该选项才回应 (RFC 7323 1.3)
+            _sent_window_scale = cfg_.window_scale &&
+                                 (!receive_isn_ || _peer_window_shift);
         }
 
-        uint16_t payload_max_size = std::min(
-            read_size, static_cast<uint16_t>(TCPConfig::MAX_PAYLOAD_SIZE));
-        read(outbound_stream, payload_max_size, payload);
-        read_size -= payload.size();
-        if (!_finished && outbound_stream.is_finished() && read_size) {
+        // 尚未分段的数据位于流中已确认部分之后
+        const uint64_t offset =
+            _segmented_bytes - outbound_stream.bytes_popped();
+        const uint64_t unsent = outbound_stream.bytes_buffered() - offset;
+        // 载荷与选项合计不超过 MSS (RFC 6691)，为要携带的 SACK 块留出空间
+        // (MIN_MSS 保证留得下)；满足条件时，下一个报文用更大的载荷探测路径 MTU
+        uint64_t max_payload = _mss - sack_option_space(sack_blocks);
+        if (const auto probe = syn ? std::nullopt : next_mtu_probe();
+            probe && read_size >= probe.value() && unsent >= probe.value()) {
+            max_payload = probe.value();
+            _mtu.probe_seqno = abs_seqno;
+            _mtu.probe_size = probe.value();
+            _mtu_probes += 1;
+        }
+        const uint64_t payload_size =
+            std::min({read_size, max_payload, unsent});
+        // 不足 MSS 的报文：流结束前的最后一段数据总是立即发送
+        const bool small = payload_size < max_payload &&
+                           !(outbound_stream.writer().is_closed() &&
+                             unsent == payload_size);
+        if (!syn && payload_size && small && hold_small_segment()) {
+            break;
+        }
+        // 发送端糊涂窗口避免 (RFC 1122 4.2.3.4)：只因窗口不足而变小的报文，
+        // 若不到对端最大窗口的一半，等在途数据的 ACK 打开窗口
+        if (!syn && payload_size < std::min(max_payload, unsent) &&
+            payload_size < _max_window / 2 && _seqnos_in_flight) {
+            break;
+        }
+        // 等待中的数据已经发出，重新计时
+        if (small || payload_size == unsent) {
+            _cork_wait_ms.reset();
+        }
+        Buffer payload = outbound_stream.peek(offset, payload_size);
+        _segmented_bytes += payload_size;
+        read_size -= payload_size;
+        if (!_finished && outbound_stream.writer().is_closed() &&
+            unsent == payload_size && read_size) {
             _finished = true;
             fin = true;
         }
         if (!(syn + payload.size() + fin)) {
+            // 窗口有余量但没有数据可发，之后的速率样本受应用限制
+            if (!_finished) {
+                sampler_.set_app_limited(_seqnos_in_flight);
+            }
             break;
         }
 
-        _messages.emplace(value_type{
-            abs_seqno, {send_isn_ + abs_seqno, syn, {payload}, fin}});
-        isn_send_queue_.emplace(abs_seqno);
+        const auto& seg = _messages.emplace_back(OutstandingSegment{
+            .seqno = abs_seqno,
+            .message = {
+                .seqno = send_isn_ + abs_seqno,
+                .SYN = syn,
+                .payload = std::move(payload),
+                .FIN = fin,
+                .mss = syn ? std::optional<uint16_t>{cfg_.mss} : std::nullopt,
+                .sack_permitted = syn && cfg_.sack,
+                .window_scale =
+                    syn && _sent_window_scale
+                        ? std::optional<uint8_t>{_rcv_window_shift}
+                        : std::nullopt,
+            }});
+        const uint64_t length = seg.message.sequence_length();
+        _seqnos_in_flight += length;
+        in_network += length;
+    }
+}
+
+bool Transceiver::hold_small_segment() {
+    if (_corked) {
+        // 从第一次被挡住时开始计时，超时后不再等待
+        if (!_cork_wait_ms) {
+            _cork_wait_ms = 0;
+        }
+        return _cork_wait_ms.value() < cfg_.cork_timeout_ms;
     }
+    // Nagle：有未确认的数据时等待，确认到达后小数据已合并成更大的报文
+    return !cfg_.nodelay && _seqnos_in_flight > 0;
+}
 
-    _popped_bytes = outbound_stream.bytes_popped();
+void Transceiver::set_cork(bool cork) {
+    _corked = cork;
+    _cork_wait_ms.reset();
 }
 
 TCPSenderMessage Transceiver::send_empty_message() const {
-    return {.seqno = send_isn_ + _started + _popped_bytes + _finished};
+    return {.seqno = send_isn_ + next_seqno(),
+            .ts_val = timestamping() ? std::optional<uint32_t>{ts_clock()}
+                                     : std::nullopt};
 }
 
-void Transceiver::receive_ack(const TCPReceiverMessage& msg) {
-    _window_size = msg.window_size;
+void Transceiver::receive_ack(const TCPReceiverMessage& msg, bool pure_ack) {
+    // 对端的 SYN 到达之前，窗口不扩大；
+    // 未经序列化的消息中 window_size 尚未右移，只需补足剩余的位数
+    const uint8_t shift = window_scaling() ? *_peer_window_shift : 0;
+    const uint64_t window =
+        uint64_t{msg.window_size}
+        << (shift - std::min(shift, msg.window_shift));
+    const bool window_changed = _window_size != window;
+    _window_size = window;
+    _max_window = std::max(_max_window, window);
+    if (window) {
+        _persist_elapsed_ms.reset();
+        _persist_backoff = 0;
+    }
 
-    if (msg.ackno) {
-        uint64_t ackno = msg.ackno->unwrap(send_isn_, _last_ackno);
-        if ((_last_ackno && ackno <= _last_ackno) ||
-            ackno > _started + _popped_bytes + _finished) {
-            return;
-        }
+    if (!msg.ackno) {
+        return;
+    }
+
+    uint64_t ackno = msg.ackno->unwrap(send_isn_, _last_ackno);
+    if ((_last_ackno && ackno < _last_ackno) || ackno > next_seqno()) {
+        return;
+    }
+
+    // 重复 ACK 不推进确认号，但其中的 SACK 块仍然需要处理
+    uint64_t acked{};
+    if (!_last_ackno || ackno > _last_ackno) {
+        acked = ackno - _last_ackno;
         _last_ackno = ackno;
+        _dup_acks = 0;
+        const uint64_t flight = _seqnos_in_flight;
 
-        auto erase_end = _messages.begin();
-        while (erase_end != _messages.end()) {
-            if (ackno <
-                erase_end->first + erase_end->second.sequence_length()) {
+        // Karn 算法：只用只发送过一次的报文测量 RTT，
+        // 取本次确认的最晚发送的报文
+        std::optional<uint64_t> rtt_sample;
+        while (!_messages.empty()) {
+            const auto& seg = _messages.front();
+            if (ackno < seg.seqno + seg.message.sequence_length()) {
                 break;
             }
-            erase_end++;
+            if (!seg.sacked) {
+                on_delivered(seg);
+            }
+            if (seg.transmissions == 1) {
+                rtt_sample = _time_ms - seg.delivery.sent_ms;
+            }
+            _seqnos_in_flight -= seg.message.sequence_length();
+            _sacked_seqnos -= seg.sacked ? seg.message.sequence_length() : 0;
+            _retransmits_queued -= seg.queued;
+            _send_index -= _send_index > 0;
+            _messages.pop_front();
         }
-        _messages.erase(_messages.begin(), erase_end);
 
-        _rto_factor = 1;
+        // 时间戳回显了触发该 ACK 的报文的发送时间，重传的报文也能测量；
+        // 每个 ACK 都产生样本 (RFC 7323 4)
+        if (timestamping() && msg.ts_ecr &&
+            static_cast<int32_t>(ts_clock() - msg.ts_ecr.value()) >= 0) {
+            const uint64_t per_rtt = (flight + 2 * _mss - 1) / (2 * _mss);
+            rtt_.on_sample(ts_clock() - msg.ts_ecr.value(), per_rtt);
+        } else if (rtt_sample) {
+            rtt_.on_sample(rtt_sample.value());
+        }
+        _rto_backoff = 0;
         consecutive_retransmissions_ = 0;
         _ms_since_last_ticked = 0;
+    } else if (pure_ack && !_messages.empty() && !window_changed) {
+        // 携带数据或 SYN/FIN 的报文、只更新窗口的 ACK 都不算重复 ACK
+        // (RFC 5681 2)
+        _dup_acks += 1;
+    }
+
+    _sack_seen |= !msg.sack_blocks.empty();
+    update_scoreboard(msg.sack_blocks, ackno);
+
+    const RateSample rate = sampler_.generate();
+    if (acked || rate.valid) {
+        cc_->on_ack({.acked = acked,
+                     .in_flight = sequence_numbers_in_flight(),
+                     .now_ms = _time_ms,
+                     .in_recovery = _fast_recovery,
+                     .delivered = sampler_.delivered(),
+                     .rate = rate});
+    }
+
+    if (_tlp_end && ackno >= _tlp_end.value()) {
+        // 没有 DSACK 时无法区分原报文与探测哪个丢失，按一次丢包处理
+        // (RFC 8985 7.4)
+        if (!_recovery_point) {
+            cc_->on_loss(sequence_numbers_in_flight(), _time_ms);
+        }
+        _tlp_end.reset();
+    }
+
+    if (_recovery_point && ackno >= _recovery_point.value()) {
+        _recovery_point.reset();
+        _fast_recovery = false;
+    } else if (_fast_recovery && acked && !_sack_seen) {
+        // 部分确认：没有 SACK 信息时，下一个未确认的报文也已丢失，
+        // 立即重传它 (RFC 6582)
+        auto& front = _messages.front();
+        if (!front.lost) {
+            front.lost = true;
+            retransmit_holes(true);
+        }
+    }
+
+    repair_losses();
+}
+
+void Transceiver::repair_losses() {
+    const bool newly_lost = mark_losses();
+    const bool probe_lost = update_mtu_search();
+    if ((newly_lost || probe_lost) && !_recovery_point) {
+        _recovery_point = next_seqno();
+        _fast_recovery = true;
+        _tlp_end.reset();
+        // 探测报文超过路径 MTU 而丢失不是拥塞信号 (RFC 4821 7.6.2)
+        if (newly_lost) {
+            cc_->on_loss(sequence_numbers_in_flight(), _time_ms);
+        }
+        // 进入恢复时无论 pipe 如何都立即重传第一个空洞 (RFC 6675 4.3)
+        retransmit_holes(true);
+    }
+    retransmit_holes();
+}
+
+void Transceiver::on_delivered(const OutstandingSegment& seg) {
+    if (!seg.transmissions) {
+        return;
+    }
+    sampler_.on_delivered(seg.delivery, seg.message.sequence_length(),
+                          _time_ms);
+
+    const uint64_t sent_ms = seg.delivery.sent_ms;
+    const uint64_t end_seq = seg.seqno + seg.message.sequence_length();
+    const uint64_t rtt_ms = _time_ms - sent_ms;
+    // 原始发送被迟到地确认时，重传报文的 RTT 会偏小，不用于 RACK
+    if (seg.transmissions > 1 && sampler_.min_rtt_ms() &&
+        rtt_ms < sampler_.min_rtt_ms().value()) {
+        return;
+    }
+    if (sent_ms > _rack.xmit_ms ||
+        (sent_ms == _rack.xmit_ms && end_seq > _rack.end_seq)) {
+        _rack.rtt_ms = rtt_ms;
+        _rack.xmit_ms = sent_ms;
+        _rack.end_seq = end_seq;
+    }
+    // 没有重传过的报文在更高的报文之后到达，说明网络发生了乱序
+    if (seg.transmissions == 1 && end_seq < _rack.fack) {
+        _rack.reordering_seen = true;
+    }
+    _rack.fack = std::max(_rack.fack, end_seq);
+}
+
+void Transceiver::update_scoreboard(const std::vector<TCPSackBlock>& blocks,
+                                    uint64_t ackno) {
+    for (const auto& block : blocks) {
+        const uint64_t left = block.left.unwrap(send_isn_, ackno);
+        const uint64_t right = block.right.unwrap(send_isn_, ackno);
+        if (right <= left || right <= ackno || right > next_seqno()) {
+            continue;
+        }
+
+        auto it = std::lower_bound(
+            _messages.begin(), _messages.end(), left,
+            [](const auto& seg, uint64_t seqno) { return seg.seqno < seqno; });
+        for (; it != _messages.end(); ++it) {
+            if (it->seqno + it->message.sequence_length() > right) {
+                break;
+            }
+            if (!it->sacked) {
+                it->sacked = true;
+                _sacked_seqnos += it->message.sequence_length();
+                on_delivered(*it);
+            }
+        }
+    }
+}
+
+bool Transceiver::mark_losses() {
+    bool newly_lost{};
+    // 收到 DUP_THRESH 个重复 ACK 时，第一个未被确认的报文已丢失
+    if (_dup_acks >= TCPConfig::DUP_THRESH) {
+        for (auto& seg : _messages) {
+            if (seg.sacked) {
+                continue;
+            }
+            if (!seg.lost) {
+                seg.lost = true;
+                newly_lost |= !is_mtu_probe(seg);
+            }
+            break;
+        }
+    }
+
+    // RACK：早于最近交付的报文发送、且超过 RTT 加乱序窗口仍未交付的
+    // 报文已丢失；尚未超时的报文在截止时间由 tick 再次检查
+    // 没有 SACK 且不在恢复中时，未确认的报文都晚于最近交付的报文发送
+    _rack.reorder_deadline_ms.reset();
+    if (cfg_.rack && _rack.rtt_ms && (_sacked_seqnos || _recovery_point)) {
+        const uint64_t wait_ms = _rack.rtt_ms.value() + rack_reorder_window();
+        for (auto& seg : _messages) {
+            if (seg.sacked || seg.lost || !seg.transmissions) {
+                continue;
+            }
+            const uint64_t sent_ms = seg.delivery.sent_ms;
+            const uint64_t end_seq = seg.seqno + seg.message.sequence_length();
+            if (sent_ms > _rack.xmit_ms ||
+                (sent_ms == _rack.xmit_ms && end_seq >= _rack.end_seq)) {
+                continue;
+            }
+            if (sent_ms + wait_ms <= _time_ms) {
+                seg.lost = true;
+                newly_lost |= !is_mtu_probe(seg);
+            } else {
+                _rack.reorder_deadline_ms =
+                    std::min(_rack.reorder_deadline_ms.value_or(UINT64_MAX),
+                             sent_ms + wait_ms);
+            }
+        }
+    }
+
+    // 从高到低遍历：若某报文之上已有 DUP_THRESH 个报文或
+    // (DUP_THRESH - 1) * MSS 字节被 SACK，则认为它已丢失
+    if (!_sacked_seqnos) {
+        return newly_lost;
+    }
+    uint64_t sacked_segments{};
+    uint64_t sacked_bytes{};
+    for (auto it = _messages.rbegin(); it != _messages.rend(); ++it) {
+        auto& seg = *it;
+        if (seg.sacked) {
+            sacked_segments += 1;
+            sacked_bytes += seg.message.sequence_length();
+            continue;
+        }
+        if (!seg.lost &&
+            (sacked_segments >= TCPConfig::DUP_THRESH ||
+             sacked_bytes > (TCPConfig::DUP_THRESH - 1) * _mss)) {
+            seg.lost = true;
+            newly_lost |= !is_mtu_probe(seg);
+        }
+    }
+    return newly_lost;
+}
+
+std::optional<uint64_t> Transceiver::next_mtu_probe() {
+    if (!cfg_.mtu_probing || !_mtu.max || _mtu.probe_seqno || _recovery_point) {
+        return {};
+    }
+    if (_mtu.done_ms) {
+        // 路径可能已经改变，隔一段时间重新搜索
+        if (_time_ms - _mtu.done_ms.value() < TCPConfig::MTU_PROBE_INTERVAL) {
+            return {};
+        }
+        _mtu.high = _mtu.max;
+        _mtu.done_ms.reset();
+    }
+    if (_mtu.high < _mtu.low + TCPConfig::MTU_PROBE_THRESHOLD) {
+        _mtu.done_ms = _time_ms;
+        return {};
+    }
+    return (_mtu.low + _mtu.high) / 2;
+}
+
+bool Transceiver::update_mtu_search() {
+    if (!_mtu.probe_seqno) {
+        return false;
+    }
+    const auto it = std::lower_bound(
+        _messages.begin(), _messages.end(), _mtu.probe_seqno.value(),
+        [](const auto& seg, uint64_t seqno) { return seg.seqno < seqno; });
+    // 已被累计确认弹出，或者被 SACK
+    const bool delivered =
+        it == _messages.end() || !is_mtu_probe(*it) || it->sacked;
+    if (delivered) {
+        _mtu.low = _mtu.probe_size;
+        _mss = _mtu.low;
+        cc_->set_mss(_mss);
+    } else if (!it->lost) {
+        return false;
+    } else {
+        _mtu.high = _mtu.probe_size - 1;
+    }
+    _mtu.probe_seqno.reset();
+    if (!delivered) {
+        // 按当前的 MSS 拆分后重传
+        split_segment(it - _messages.begin());
+    }
+    return !delivered;
+}
+
+void Transceiver::split_segment(size_t index) {
+    const OutstandingSegment seg = _messages[index];
+    const uint64_t size = seg.message.payload.size();
+    if (seg.message.SYN || seg.sacked || size <= _mss) {
+        return;
+    }
+
+    std::vector<OutstandingSegment> pieces;
+    for (uint64_t offset = 0; offset < size; offset += _mss) {
+        OutstandingSegment piece = seg;
+        piece.seqno = seg.seqno + offset;
+        piece.message.seqno =
+            seg.message.seqno + static_cast<uint32_t>(offset);
+        piece.message.payload = seg.message.payload.substr(offset, _mss);
+        piece.message.FIN = seg.message.FIN && offset + _mss >= size;
+        pieces.push_back(std::move(piece));
+    }
+    _messages.erase(_messages.begin() + index);
+    _messages.insert(_messages.begin() + index, pieces.begin(), pieces.end());
+
+    const size_t added = pieces.size() - 1;
+    _send_index += index < _send_index ? added : 0;
+    _retransmits_queued += seg.queued ? added : 0;
+}
+
+uint64_t Transceiver::rack_reorder_window() const {
+    // 同一个 tick 内发送的报文无法按时间区分先后，窗口至少为一个计时粒度
+    constexpr uint64_t granularity = TCPConfig::CLOCK_GRANULARITY;
+    if (!_rack.reordering_seen && _recovery_point) {
+        return granularity;
+    }
+    const uint64_t window = std::min(sampler_.min_rtt_ms().value_or(0) / 4,
+                                     rtt_.srtt_ms().value_or(0));
+    return std::max(window, granularity);
+}
+
+std::optional<uint64_t> Transceiver::probe_timeout() const {
+    // 恢复中、已有 SACK 空洞 (由 RACK 处理)、或本轮已探测过时不探测
+    if (!cfg_.rack || !_send_index || _recovery_point || _tlp_end ||
+        !rtt_.srtt_ms() || _messages.front().message.SYN) {
+        return {};
+    }
+    for (const auto& seg : _messages) {
+        if (seg.sacked) {
+            return {};
+        }
+    }
+
+    uint64_t pto = std::max(2 * rtt_.srtt_ms().value(),
+                            uint64_t{2} * TCPConfig::CLOCK_GRANULARITY);
+    // 只有一个报文在途时，对端可能延迟确认
+    if (sequence_numbers_in_flight() <= _mss) {
+        pto += TCPConfig::MAX_ACK_DELAY;
+    }
+    // 不晚于重传超时，否则直接等待超时重传
+    if (pto >= rtt_.backed_off_rto_ms(_rto_backoff)) {
+        return {};
+    }
+    return pto;
+}
+
+uint64_t Transceiver::send_window() const {
+    if (!_fast_recovery || _sack_seen) {
+        return cc_->cwnd();
+    }
+    return cc_->cwnd() + _dup_acks * _mss;
+}
+
+void Transceiver::retransmit_holes(bool first_only) {
+    if (!_recovery_point) {
+        return;
+    }
+    uint64_t in_network = pipe();
+    for (size_t i = 0; i < _send_index; i++) {
+        auto& seg = _messages[i];
+        if (!seg.lost || seg.sacked || seg.retransmitted) {
+            continue;
+        }
+        if (first_only) {
+            seg.retransmitted = true;
+            queue_retransmit(seg);
+            return;
+        }
+        if (in_network + seg.message.sequence_length() > send_window()) {
+            break;
+        }
+        seg.retransmitted = true;
+        in_network += seg.message.sequence_length();
+        queue_retransmit(seg);
     }
 }
 
 void Transceiver::tick(const uint64_t ms_since_last_tick) {
+    _time_ms += ms_since_last_tick;
+    if (_cork_wait_ms) {
+        _cork_wait_ms.value() += ms_since_last_tick;
+    }
+    if (_persist_elapsed_ms) {
+        _persist_elapsed_ms.value() += ms_since_last_tick;
+        if (_persist_elapsed_ms.value() >=
+            rtt_.backed_off_rto_ms(_persist_backoff)) {
+            _window_probe_pending = true;
+            _window_probes += 1;
+            _persist_backoff += 1;
+            _persist_elapsed_ms = 0;
+        }
+    }
     if (_messages.empty()) {
         return;
     }
     _ms_since_last_ticked += ms_since_last_tick;
-    if (_ms_since_last_ticked >= initial_RTO_ms_ * _rto_factor) {
-        isn_send_queue_.emplace(_messages.begin()->first);
-        if (_window_size) {
-            _rto_factor *= 2;
-            consecutive_retransmissions_ += 1;
+
+    if (_rack.reorder_deadline_ms &&
+        _time_ms >= _rack.reorder_deadline_ms.value()) {
+        repair_losses();
+        if (_retransmits_queued) {
+            _ms_since_last_ticked = 0;
+            return;
         }
+    }
+
+    // 尾部丢包探测：重传最后发送的报文，让对端用 ACK (和 SACK) 暴露丢包
+    if (const auto pto = probe_timeout();
+        pto && _ms_since_last_ticked >= pto.value()) {
+        _tlp_end = next_seqno();
+        _loss_probes += 1;
+        queue_retransmit(_messages[_send_index - 1]);
         _ms_since_last_ticked = 0;
         return;
     }
+
+    if (_ms_since_last_ticked >= rtt_.backed_off_rto_ms(_rto_backoff)) {
+        // 超时后认为所有未被 SACK 的报文都已丢失，
+        // 之后每收到一个 ACK 就在窗口允许的范围内继续重传空洞
+        for (size_t i = 0; i < _send_index; i++) {
+            auto& seg = _messages[i];
+            seg.lost = !seg.sacked;
+            seg.retransmitted = false;
+        }
+        update_mtu_search();
+        // 连续超时可能是路径 MTU 变小造成的黑洞，退回探测的起点 (RFC 4821 7.7)
+        if (cfg_.mtu_probing &&
+            consecutive_retransmissions_ + 1 >= TCPConfig::MTU_BLACKHOLE_RTOS &&
+            _mss > TCPConfig::MTU_PROBE_BASE_MSS) {
+            _mss = TCPConfig::MTU_PROBE_BASE_MSS;
+            _mtu.low = _mss;
+            _mtu.done_ms.reset();
+            cc_->set_mss(_mss);
+            for (size_t i = _messages.size(); i-- > 0;) {
+                split_segment(i);
+            }
+        }
+        _messages.front().retransmitted = true;
+        _recovery_point = next_seqno();
+        _fast_recovery = false;
+        _dup_acks = 0;
+        _tlp_end.reset();
+
+        queue_retransmit(_messages.front());
+        // 零窗口下的超时不是拥塞信号；连续超时只在第一次降低窗口
+        if (_window_size && !consecutive_retransmissions_) {
+            cc_->on_rto(sequence_numbers_in_flight(), _time_ms);
+        }
+        _rto_backoff += 1;
+        consecutive_retransmissions_ += 1;
+        _ms_since_last_ticked = 0;
+        return;
+    }
+}
+
+std::optional<uint64_t> Transceiver::next_timeout_ms() const {
+    std::optional<uint64_t> next{};
+    // 已经过的时间超过期限时为 0，由下一次 tick 立即处理
+    const auto arm = [&next](uint64_t timeout, uint64_t elapsed) {
+        const uint64_t left = timeout > elapsed ? timeout - elapsed : 0;
+        next = std::min(next.value_or(left), left);
+    };
+    if (_cork_wait_ms) {
+        arm(cfg_.cork_timeout_ms, _cork_wait_ms.value());
+    }
+    if (_persist_elapsed_ms) {
+        arm(rtt_.backed_off_rto_ms(_persist_backoff),
+            _persist_elapsed_ms.value());
+    }
+    if (_messages.empty()) {
+        return next;
+    }
+    if (_rack.reorder_deadline_ms) {
+        arm(_rack.reorder_deadline_ms.value(), _time_ms);
+    }
+    if (const auto pto = probe_timeout()) {
+        arm(pto.value(), _ms_since_last_ticked);
+    }
+    arm(rtt_.backed_off_rto_ms(_rto_backoff), _ms_since_last_ticked);
+    return next;
+}
+
+uint64_t Transceiver::pacing_rate() const {
+    if (!cfg_.pacing) {
+        return 0;
+    }
+    // 拥塞控制自己给出速率 (BBR) 时使用它，否则每个 RTT 发出一个窗口
+    uint64_t rate = cc_->pacing_rate();
+    if (!rate && rtt_.srtt_ms()) {
+        const uint64_t gain = cc_->in_slow_start() ? TCPConfig::PACING_SS_GAIN
+                                                   : TCPConfig::PACING_CA_GAIN;
+        rate = cc_->cwnd() * 1000 * gain / 100 /
+               std::max(rtt_.srtt_ms().value(), uint64_t{1});
+    }
+    if (cfg_.max_pacing_rate && (!rate || rate > cfg_.max_pacing_rate)) {
+        rate = cfg_.max_pacing_rate;
+    }
+    return rate;
+}
+
+uint64_t Transceiver::pacing_burst() const {
+    const uint64_t rate = pacing_rate();
+    if (!rate) {
+        return 0;
+    }
+    // 约 1 ms 的数据量，至少两个报文
+    return std::max(2 * _mss, rate / 1000);
+}
+
+TCPStats Transceiver::stats() const {
+    return {
+        .congestion_control = cc_->name(),
+        .cwnd = cc_->cwnd(),
+        .ssthresh = cc_->ssthresh(),
+        .pacing_rate = pacing_rate(),
+        .pacing_burst = pacing_burst(),
+        .delivery_rate = sampler_.delivery_rate(),
+        .min_rtt_ms = sampler_.min_rtt_ms(),
+        .srtt_ms = rtt_.srtt_ms(),
+        .rttvar_ms = rtt_.rttvar_ms(),
+        .rto_ms = rtt_.backed_off_rto_ms(_rto_backoff),
+        .bytes_delivered = sampler_.delivered(),
+        .segments_retransmitted = _retransmitted_segments,
+        .loss_probes = _loss_probes,
+        .mss = _mss,
+        .mtu_probes = _mtu_probes,
+        .window_probes = _window_probes,
+    };
+}
+
+void Transceiver::forgo_rtt_samples() {
+    // Karn 算法与交付速率采样都不用重传过的报文测量 RTT，按重传过处理
+    for (auto& seg : _messages) {
+        seg.transmissions = std::max(seg.transmissions, uint16_t{2});
+        seg.delivery.retransmitted = true;
+    }
 }
 
 /* 接收端 */
@@ -137,24 +807,134 @@ void Transceiver::receive_isn(TCPSenderMessage message,
                               Writer& inbound_stream) {
     if (message.SYN) {
         receive_isn_ = Wrap32{message.seqno};
+        _peer_sack_permitted = message.sack_permitted;
+        if (message.window_scale) {
+            _peer_window_shift = std::min(message.window_scale.value(),
+                                          TCPConfig::MAX_WINDOW_SHIFT);
+        }
+        _peer_timestamps = message.ts_val.has_value();
+        _ts_recent = message.ts_val.value_or(0);
+
+        const uint64_t peer_mss =
+            std::max(message.mss.value_or(TCPConfig::DEFAULT_PEER_MSS),
+                     TCPConfig::MIN_MSS);
+        _mss = std::min(uint64_t{std::max(cfg_.mss, TCPConfig::MIN_MSS)},
+                        peer_mss) -
+               (timestamping() ? TIMESTAMP_OPTION_SPACE : 0);
+        if (cfg_.mtu_probing) {
+            // 从保守的大小开始，向协商的 MSS 搜索
+            _mtu = {.low = std::min(_mss,
+                                    uint64_t{TCPConfig::MTU_PROBE_BASE_MSS}),
+                    .high = _mss,
+                    .max = _mss};
+            _mss = _mtu.low;
+        }
+        // 拥塞窗口以 MSS 为单位，尚未发送数据时按协商的 MSS 重建
+        if (!_segmented_bytes && cc_->mss() != _mss) {
+            cc_ = make_congestion_control(cfg_, _mss);
+        }
+    }
+    if (!receive_isn_ || paws_reject(message)) {
+        return;
+    }
+
+    const uint64_t seqno = message.seqno.unwrap(receive_isn_.value(),
+                                                inbound_stream.bytes_pushed());
+    // 只记录不晚于 ackno 的报文，ACK 回显的是最早未确认的报文 (RFC 7323 4.3)
+    if (timestamping() && message.ts_val &&
+        seqno <= inbound_stream.bytes_pushed() + 1) {
+        _ts_recent = message.ts_val.value();
+    }
+    reassembler.insert(seqno - !message.SYN, message.payload, message.FIN,
+                       inbound_stream);
+}
+
+bool Transceiver::receive_predicted(const TCPSenderMessage& message,
+                                    const TCPReceiverMessage& msg,
+                                    Reassembler& reassembler,
+                                    Writer& inbound_stream) {
+    // 连接已建立，没有 SACK 信息，也不在丢包恢复或尾部探测中
+    if (!receive_isn_ || message.SYN || message.FIN || !msg.ackno ||
+        !msg.sack_blocks.empty() || _recovery_point || _tlp_end ||
+        _sacked_seqnos) {
+        return false;
+    }
+    // 报文恰好从 rcv.nxt 开始，窗口没有变化，时间戳不早于记录的值
+    const uint8_t shift = window_scaling() ? *_peer_window_shift : 0;
+    if (!(message.seqno ==
+          receive_isn_.value() + 1 + inbound_stream.bytes_pushed()) ||
+        (uint64_t{msg.window_size}
+         << (shift - std::min(shift, msg.window_shift))) != _window_size ||
+        (timestamping() && (!message.ts_val || paws_reject(message)))) {
+        return false;
     }
-    if (receive_isn_) {
-        reassembler.insert(message.seqno.unwrap(receive_isn_.value(),
-                                                inbound_stream.bytes_pushed()) -
-                               !message.SYN,
-                           message.payload, message.FIN, inbound_stream);
+
+    const bool ack_advanced = !(msg.ackno == send_isn_ + _last_ackno);
+    if (message.payload.empty()) {
+        // 纯 ACK：推进 snd.una；重复 ACK 走完整路径
+        if (!ack_advanced) {
+            return false;
+        }
+        receive_ack(msg);
+    } else {
+        // 纯数据：不确认新的数据，本端也没有在途的数据，
+        // 否则交给完整路径处理 SACK 与丢包恢复
+        if (ack_advanced || !_messages.empty() ||
+            !reassembler.push_in_order(inbound_stream.bytes_pushed(),
+                                       message.payload, inbound_stream)) {
+            return false;
+        }
+    }
+    if (timestamping()) {
+        _ts_recent = message.ts_val.value();
+    }
+    return true;
+}
+
+size_t Transceiver::sack_blocks_fit(const TCPSenderMessage& message) const {
+    const uint64_t payload = message.payload.size();
+    size_t blocks = TCPConfig::MAX_SACK_BLOCKS;
+    while (blocks && payload + sack_option_space(blocks) > _mss) {
+        blocks -= 1;
     }
+    return blocks;
 }
 
-TCPReceiverMessage Transceiver::send_ack(const Writer& inbound_stream) const {
+bool Transceiver::paws_reject(const TCPSenderMessage& message) const {
+    // 按 32 位回绕比较；不带时间戳的报文照常接收
+    return timestamping() && !message.SYN && message.ts_val &&
+           static_cast<int32_t>(message.ts_val.value() - _ts_recent) < 0;
+}
+
+TCPReceiverMessage Transceiver::send_ack(const Reassembler& reassembler,
+                                         const Writer& inbound_stream) const {
     auto ackno = receive_isn_;
     if (ackno) {
         ackno.emplace(ackno.value() + 1 + inbound_stream.bytes_pushed() +
                       inbound_stream.is_closed());
     }
+
+    std::vector<TCPSackBlock> sack_blocks;
+    if (receive_isn_ && cfg_.sack && _peer_sack_permitted) {
+        const size_t max_blocks = timestamping()
+                                      ? TCPConfig::MAX_SACK_BLOCKS_WITH_TS
+                                      : TCPConfig::MAX_SACK_BLOCKS;
+        for (const auto& [first, last] :
+             reassembler.pending_ranges(max_blocks)) {
+            sack_blocks.push_back({receive_isn_.value() + 1 + first,
+                                   receive_isn_.value() + 1 + last});
+        }
+    }
+
+    const uint8_t shift = window_scaling() ? _rcv_window_shift : 0;
     return {
         .ackno = ackno,
-        .window_size = static_cast<uint16_t>(std::min(
-            inbound_stream.available_capacity(), uint64_t{UINT16_MAX})),
+        .window_size = static_cast<uint32_t>(
+            std::min(inbound_stream.available_capacity(),
+                     uint64_t{UINT16_MAX} << shift)),
+        .window_shift = shift,
+        .sack_blocks = std::move(sack_blocks),
+        .ts_ecr = timestamping() ? std::optional<uint32_t>{_ts_recent}
+                                 : std::nullopt,
     };
 }
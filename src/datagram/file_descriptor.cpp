@@ -107,13 +107,38 @@ void FileDescriptor::read(string& buffer) {
   buffer.resize(bytes_read);
 }
 
+size_t FileDescriptor::read(span<char> buffer) {
+  const ssize_t bytes_read = ::read(fd_num(), buffer.data(), buffer.size());
+  if (bytes_read < 0) {
+    if (internal_fd_->non_blocking_ and
+        (errno == EAGAIN or errno == EINPROGRESS)) {
+      return 0;
+    }
+    throw unix_error{"read"};
+  }
+
+  register_read();
+
+  if (bytes_read == 0) {
+    internal_fd_->eof_ = true;
+  }
+
+  if (bytes_read > static_cast<ssize_t>(buffer.size())) {
+    throw runtime_error("read() read more than requested");
+  }
+
+  return bytes_read;
+}
+
 void FileDescriptor::read(vector<string>& buffers) {
   if (buffers.empty()) {
     return;
   }
 
-  buffers.back().clear();
-  buffers.back().resize(kReadBufferSize);
+  // 与 read(string&) 相同：最后一个缓冲区为空时才按默认大小分配
+  if (buffers.back().empty()) {
+    buffers.back().resize(kReadBufferSize);
+  }
 
   vector<iovec> iovecs;
   iovecs.reserve(buffers.size());
@@ -2,6 +2,7 @@
 
 #include <arpa/inet.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <iostream>
 #include <sstream>
@@ -11,16 +12,142 @@
 
 static constexpr uint32_t TCPHeaderMinLen = 5;  // 32-bit words
 
+/* TCP 选项类型 */
+static constexpr uint8_t TCPOptEnd = 0;
+static constexpr uint8_t TCPOptNop = 1;
+static constexpr uint8_t TCPOptMss = 2;
+static constexpr uint8_t TCPOptWindowScale = 3;
+static constexpr uint8_t TCPOptSackPermitted = 4;
+static constexpr uint8_t TCPOptSack = 5;
+static constexpr uint8_t TCPOptTimestamps = 8;
+
 using namespace std;
 
+class Wrap32Serializable : public Wrap32 {
+ public:
+  uint32_t raw_value() const { return raw_value_; }
+};
+
+//! 以网络字节序从 options 中读取一个 uint32_t
+static uint32_t option_u32(string_view options, size_t pos) {
+  uint32_t ret{};
+  for (size_t i = 0; i < 4; i++) {
+    ret = (ret << 8) | static_cast<uint8_t>(options[pos + i]);
+  }
+  return ret;
+}
+
+//! 以网络字节序向 options 中写入一个 uint32_t
+static void append_u32(string& options, uint32_t val) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    options.push_back(static_cast<char>(val >> shift));
+  }
+}
+
+//! 解析 TCP 选项，无法识别的选项直接跳过
+static bool parse_options(string_view options, TCPSegment& seg) {
+  size_t pos = 0;
+  while (pos < options.size()) {
+    const uint8_t kind = options[pos];
+    if (kind == TCPOptEnd) {
+      break;
+    }
+    if (kind == TCPOptNop) {
+      pos += 1;
+      continue;
+    }
+    if (pos + 2 > options.size()) {
+      return false;
+    }
+    const uint8_t len = options[pos + 1];
+    if (len < 2 || pos + len > options.size()) {
+      return false;
+    }
+
+    switch (kind) {
+      case TCPOptMss:
+        if (len != 4) {
+          return false;
+        }
+        seg.sender_message.mss =
+            static_cast<uint8_t>(options[pos + 2]) << 8 |
+            static_cast<uint8_t>(options[pos + 3]);
+        break;
+      case TCPOptWindowScale:
+        if (len != 3) {
+          return false;
+        }
+        seg.sender_message.window_scale = options[pos + 2];
+        break;
+      case TCPOptSackPermitted:
+        seg.sender_message.sack_permitted = true;
+        break;
+      case TCPOptTimestamps:
+        if (len != 10) {
+          return false;
+        }
+        seg.sender_message.ts_val = option_u32(options, pos + 2);
+        if (seg.receiver_message.ackno) {
+          seg.receiver_message.ts_ecr = option_u32(options, pos + 6);
+        }
+        break;
+      case TCPOptSack:
+        for (size_t off = 2; off + 8 <= len; off += 8) {
+          seg.receiver_message.sack_blocks.push_back(
+              {Wrap32{option_u32(options, pos + off)},
+               Wrap32{option_u32(options, pos + off + 4)}});
+        }
+        break;
+      default:
+        break;
+    }
+    pos += len;
+  }
+  return true;
+}
+
+//! 生成 TCP 选项，补齐到 4 字节的整数倍
+static string serialize_options(const TCPSegment& seg) {
+  string options;
+  if (seg.sender_message.SYN && seg.sender_message.mss) {
+    const uint16_t mss = seg.sender_message.mss.value();
+    options += {TCPOptMss, 4, static_cast<char>(mss >> 8),
+                static_cast<char>(mss)};
+  }
+  if (seg.sender_message.SYN && seg.sender_message.window_scale) {
+    options += {TCPOptNop, TCPOptWindowScale, 3,
+                static_cast<char>(seg.sender_message.window_scale.value())};
+  }
+  if (seg.sender_message.SYN && seg.sender_message.sack_permitted) {
+    options += {TCPOptNop, TCPOptNop, TCPOptSackPermitted, 2};
+  }
+  if (seg.sender_message.ts_val) {
+    options += {TCPOptNop, TCPOptNop, TCPOptTimestamps, 10};
+    append_u32(options, seg.sender_message.ts_val.value());
+    append_u32(options, seg.receiver_message.ts_ecr.value_or(0));
+  }
+  if (!seg.receiver_message.sack_blocks.empty()) {
+    const size_t len = 2 + 8 * seg.receiver_message.sack_blocks.size();
+    options += {TCPOptNop, TCPOptNop, TCPOptSack, static_cast<char>(len)};
+    for (const auto& block : seg.receiver_message.sack_blocks) {
+      append_u32(options, Wrap32Serializable{block.left}.raw_value());
+      append_u32(options, Wrap32Serializable{block.right}.raw_value());
+    }
+  }
+  while (options.size() % 4) {
+    options.push_back(TCPOptEnd);
+  }
+  return options;
+}
+
 void TCPSegment::parse(Parser& parser,
-                       uint32_t datagram_layer_pseudo_checksum) {
-  {
+                       optional<uint32_t> datagram_layer_pseudo_checksum) {
+  if (datagram_layer_pseudo_checksum) {
     /* 验证校验和 */
     Parser parser2 = parser;
     Buffer all_remaining;
     parser2.all_remaining(all_remaining);
-    InternetChecksum check{datagram_layer_pseudo_checksum};
+    InternetChecksum check{datagram_layer_pseudo_checksum.value()};
     check.add(all_remaining);
     if (check.value()) {
       parser.set_error();
@@ -53,40 +180,55 @@ void TCPSegment::parse(Parser& parser,
   sender_message.SYN = octet & 0b0000'0010;
   sender_message.FIN = octet & 0b0000'0001;
 
-  parser.integer(receiver_message.window_size);
+  parser.integer(raw16);
+  receiver_message.window_size = raw16;
   parser.integer(udinfo.cksum);
   parser.integer(raw16);  // urgent pointer
 
-  // 跳过标题中的任何选项或任何额外内容
+  // 解析报头中的选项
   if (data_offset < TCPHeaderMinLen) {
     parser.set_error();
+    return;
+  }
+  string options(data_offset * 4 - TCPHeaderMinLen * 4, 0);
+  parser.string(options);
+  if (parser.has_error() || !parse_options(options, *this)) {
+    parser.set_error();
+    return;
   }
-  parser.remove_prefix(data_offset * 4 - TCPHeaderMinLen * 4);
 
   parser.all_remaining(sender_message.payload);
 }
 
-class Wrap32Serializable : public Wrap32 {
- public:
-  uint32_t raw_value() const { return raw_value_; }
-};
+size_t TCPSegment::header_length() const {
+  return TCPHeaderMinLen * 4 + serialize_options(*this).size();
+}
 
 void TCPSegment::serialize(Serializer& serializer) const {
+  const string options = serialize_options(*this);
   serializer.integer(udinfo.src_port);
   serializer.integer(udinfo.dst_port);
   serializer.integer(Wrap32Serializable{sender_message.seqno}.raw_value());
   serializer.integer(
       Wrap32Serializable{receiver_message.ackno.value_or(Wrap32{0})}
           .raw_value());
-  serializer.integer(uint8_t{TCPHeaderMinLen << 4});  // data offset
+  const auto data_offset = TCPHeaderMinLen + options.size() / 4;
+  serializer.integer(static_cast<uint8_t>(data_offset << 4));  // data offset
   const uint8_t flags =
       (receiver_message.ackno.has_value() ? 0b0001'0000U : 0) |
       (reset ? 0b0000'0100U : 0) | (sender_message.SYN ? 0b0000'0010U : 0) |
       (sender_message.FIN ? 0b0000'0001U : 0);
   serializer.integer(flags);
-  serializer.integer(receiver_message.window_size);
+  // SYN 中的窗口不扩大 (RFC 7323 2.2)
+  const uint8_t shift =
+      sender_message.SYN ? 0 : receiver_message.window_shift;
+  serializer.integer(static_cast<uint16_t>(std::min(
+      receiver_message.window_size >> shift, uint32_t{UINT16_MAX})));
   serializer.integer(udinfo.cksum);
   serializer.integer(uint16_t{0});  // urgent pointer
+  for (const char c : options) {
+    serializer.integer(static_cast<uint8_t>(c));
+  }
   serializer.buffer(sender_message.payload);
 }
 
@@ -1,9 +1,11 @@
 #pragma once
 
-#include <queue>
+#include <deque>
 #include <string>
 #include <string_view>
 
+#include "buffer/string_buffer.h"
+
 class Reader;
 class Writer;
 
@@ -11,12 +13,24 @@ class Writer;
  * @brief 有大小限制的字节流，用于 TCP 通信时收发消息，详见 TCPEndpoint
  */
 class StreamBuffer {
+ public:
+  //! 短于 SMALL_WRITE 的写入复制到末尾的合并块中，避免 peek 的范围跨块；
+  //! 更长的写入直接共享内存
+  static constexpr size_t SMALL_WRITE = 1024;
+  static constexpr size_t MERGED_CHUNK = 16384;  //!< 合并块的容量
+
  protected:
   uint64_t capacity_;
   bool _error{};
-  std::queue<std::string> _buffer;
+  std::deque<Buffer> _buffer;
   std::string_view _front_view;
   size_t _bytes_buffered{};
+  bool _merging{};  //!< 末尾的块是合并块，可以继续追加
+
+  /* peek(offset, len) 的游标：上次查看的块及其在流中的起点，
+     随发送向后移动，不必每次从队首查找 */
+  mutable size_t _cursor_chunk{};
+  mutable uint64_t _cursor_start{};
 
   size_t _bytes_popped{};
   size_t _bytes_pushed{};
@@ -33,10 +47,15 @@ class StreamBuffer {
 class Writer : public StreamBuffer {
  public:
   void push(std::string data);
+  void push(Buffer data);  //!< 与 data 共享内存，不复制
   void close();
   void set_error();
 
+  //! 调整容量，不小于已缓存的字节数
+  void set_capacity(uint64_t capacity);
+
   bool is_closed() const;
+  uint64_t capacity() const;
   uint64_t available_capacity() const;
   uint64_t bytes_pushed() const;
 };
@@ -44,6 +63,10 @@ class Writer : public StreamBuffer {
 class Reader : public StreamBuffer {
  public:
   std::string_view peek() const;  //!< 查看 Buffer 中下一个字节
+  //! 查看缓存中 [offset, offset + len) 的数据，与缓冲区共享内存；
+  //! 只有跨越多个块的范围需要拼接。从上次查看的位置向后查找，
+  //! 向前查看 (如重传) 时从队首开始
+  Buffer peek(uint64_t offset, uint64_t len) const;
   void pop(uint64_t len);
 
   bool is_finished() const;  //!< Stream 是否结束 (closed and fully popped)?
@@ -1,26 +1,69 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <string_view>
 
 /**
  * @brief std::string 的包装类，用于存放报文信息
+ * 可以是另一个 Buffer 的切片，与其共享内存而不复制数据
  */
 class Buffer {
   std::shared_ptr<std::string> buffer_;
+  size_t offset_{};                   //!< 切片在字符串中的起点
+  size_t length_{std::string::npos};  //!< 切片长度，npos 表示到末尾
+
+  //! 修改切片前先复制出独立的字符串
+  void detach() {
+    if (offset_ || length_ != std::string::npos) {
+      buffer_ = std::make_shared<std::string>(std::string_view{*this});
+      offset_ = 0;
+      length_ = std::string::npos;
+    }
+  }
 
  public:
   // NOLINTBEGIN(*-explicit-*)
 
   Buffer(std::string str = {})
       : buffer_(make_shared<std::string>(std::move(str))) {}
-  operator std::string_view() const { return *buffer_; }
-  operator std::string &() { return *buffer_; }
+  operator std::string_view() const {
+    return std::string_view{*buffer_}.substr(offset_, length_);
+  }
+  operator std::string &() {
+    detach();
+    return *buffer_;
+  }
 
   // NOLINTEND(*-explicit-*)
 
-  std::string &&release() { return std::move(*buffer_); }
-  size_t size() const { return buffer_->size(); }
-  size_t length() const { return buffer_->length(); }
-  bool empty() const { return buffer_->empty(); }
+  std::string &&release() {
+    detach();
+    return std::move(*buffer_);
+  }
+  size_t size() const { return std::string_view{*this}.size(); }
+  size_t length() const { return size(); }
+  bool empty() const { return size() == 0; }
+
+  //! 切片延伸到字符串末尾且容量足够时，在字符串末尾原地追加 data 并延长切片；
+  //! 不重新分配内存，其他共享该字符串的切片不受影响
+  bool try_append(std::string_view data) {
+    if (offset_ + size() != buffer_->size() ||
+        buffer_->capacity() - buffer_->size() < data.size()) {
+      return false;
+    }
+    length_ = size() + data.size();
+    buffer_->append(data);
+    return true;
+  }
+
+  //! 返回 [pos, pos + len) 的切片，不复制数据
+  Buffer substr(size_t pos, size_t len = std::string::npos) const {
+    Buffer res = *this;
+    pos = std::min(pos, size());
+    res.offset_ += pos;
+    res.length_ = std::min(len, size() - pos);
+    return res;
+  }
 };
@@ -7,19 +7,87 @@
 #include "datagram/address.h"
 #include "datagram/wrapping_integers.h"
 
+/**
+ * @brief 可选的拥塞控制算法
+ */
+enum class CongestionAlgorithm { NewReno, Cubic, Bbr };
+
 /**
  * @brief 一条 TCP 信道的配置内容
  */
 class TCPConfig {
  public:
   static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< 容量大小 (bytes)
-  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< 最大报文载荷 (bytes)
+  //! 接收缓冲区自动调整的默认上限 (bytes)
+  static constexpr size_t MAX_RECV_CAPACITY_DFLT = 1 << 20;
+  //! 发送缓冲区自动调整的默认上限 (bytes)
+  static constexpr size_t MAX_SEND_CAPACITY_DFLT = 4 << 20;
+  //! 没有数据到达多久后，接收缓冲区缩回初始大小 (ms)
+  static constexpr uint32_t RCV_SPACE_IDLE_MS = 1000;
+  //! 默认 MSS：1500 字节的 MTU 减去 IPv4 与 TCP 报头
+  static constexpr uint16_t DEFAULT_MSS = 1460;
+  static constexpr uint16_t DEFAULT_PEER_MSS = 536;  //!< 对端未通告时的 MSS
+  static constexpr uint16_t MIN_MSS = 88;  //!< MSS 下限，避免过小的报文
+  /* 分组层路径 MTU 探测 (RFC 4821) */
+  static constexpr uint16_t MTU_PROBE_BASE_MSS = 1024;  //!< 探测的起点
+  static constexpr uint16_t MTU_PROBE_THRESHOLD = 8;  //!< 搜索区间收敛的宽度
+  static constexpr uint32_t MTU_PROBE_INTERVAL = 600000;  //!< 重新探测 (ms)
+  static constexpr unsigned MTU_BLACKHOLE_RTOS = 2;  //!< 判定黑洞的连续超时
   static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< 默认重传时间 (ms)
+  static constexpr uint16_t MIN_RTO_DFLT = 20;      //!< 默认最小重传时间 (ms)
+  static constexpr uint32_t MAX_RTO_DFLT = 60000;   //!< 默认最大重传时间 (ms)
+  static constexpr uint16_t CLOCK_GRANULARITY = 10;  //!< 计时粒度 (ms)
+  static constexpr uint16_t MAX_ACK_DELAY = 200;  //!< 对端最长的延迟确认 (ms)
+  static constexpr uint16_t ACK_DELAY_DFLT = 40;  //!< 默认的延迟确认时间 (ms)
+  static constexpr unsigned ACK_EVERY_DFLT = 2;  //!< 默认每两个报文确认一次
+  static constexpr uint16_t CORK_TIMEOUT_DFLT = 200;  //!< cork 的最长等待 (ms)
   static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< 最大重传次数
+  static constexpr size_t LISTEN_BACKLOG_DFLT = 128;  //!< 监听队列的默认上限
+  //! SYN cookie 编码时间的粒度 (ms)，cookie 在发出的周期和下一个周期内有效
+  static constexpr uint32_t SYN_COOKIE_PERIOD_MS = 64000;
+  static constexpr unsigned DUP_THRESH = 3;  //!< 判定丢包的重复阈值 (RFC 6675)
+  static constexpr size_t MAX_SACK_BLOCKS = 4;  //!< 每个报文最多携带的 SACK 块
+  //! 时间戳选项占用 12 字节后，40 字节的选项空间只够 3 个 SACK 块
+  static constexpr size_t MAX_SACK_BLOCKS_WITH_TS = 3;
+  static constexpr unsigned INITIAL_CWND = 10;  //!< 初始拥塞窗口 (segments)
+  static constexpr uint8_t MAX_WINDOW_SHIFT = 14;  //!< 窗口扩大因子上限
+  /* 由 cwnd / srtt 推算发送速率时的增益 (%)，留出窗口增长的余量 */
+  static constexpr uint64_t PACING_SS_GAIN = 200;  //!< 慢启动
+  static constexpr uint64_t PACING_CA_GAIN = 120;  //!< 拥塞避免
+
+  uint16_t rt_timeout = TIMEOUT_DFLT;  //!< 尚无 RTT 样本时的重传时间
+  uint16_t min_rto = MIN_RTO_DFLT;
+  uint32_t max_rto = MAX_RTO_DFLT;
+  size_t recv_capacity = DEFAULT_CAPACITY;  //!< 接收缓冲区 (初始) 大小
+  //! 按应用每个 RTT 读取的字节数调整接收缓冲区，最大到 max_recv_capacity
+  bool rcvbuf_autotune = true;
+  size_t max_recv_capacity = MAX_RECV_CAPACITY_DFLT;
+  size_t send_capacity = DEFAULT_CAPACITY;  //!< 发送缓冲区 (初始) 大小
+  //! 未确认的数据也占用发送缓冲区：按可发送的窗口扩大发送缓冲区，
+  //! 最大到 max_send_capacity
+  bool sndbuf_autotune = true;
+  size_t max_send_capacity = MAX_SEND_CAPACITY_DFLT;
+  uint16_t mss = DEFAULT_MSS;  //!< 在 SYN 中通告，也是发送载荷的上限
+  //! 延迟确认 (RFC 1122 4.2.3.2)：收到按序数据后最多等待的时间，0 为立即确认
+  uint16_t ack_delay_ms = ACK_DELAY_DFLT;
+  unsigned ack_every = ACK_EVERY_DFLT;  //!< 至少每收到这么多个报文确认一次
+  //! 关闭 Nagle 算法 (RFC 896)：有未确认的数据时也立即发送不足 MSS 的报文
+  bool nodelay = false;
+  //! 类似 TCP_CORK：不足 MSS 的数据等到凑满或超时才发送
+  bool cork = false;
+  uint16_t cork_timeout_ms = CORK_TIMEOUT_DFLT;
 
-  uint16_t rt_timeout = TIMEOUT_DFLT;
-  size_t recv_capacity = DEFAULT_CAPACITY;
-  size_t send_capacity = DEFAULT_CAPACITY;
+  bool sack = true;  //!< 是否启用 SACK (RFC 2018)
+  bool rack = true;  //!< 是否启用 RACK-TLP 丢包检测 (RFC 8985)
+  bool window_scale = true;  //!< 是否启用窗口扩大选项 (RFC 7323)
+  bool timestamps = true;    //!< 是否启用时间戳选项 (RFC 7323)
+  bool mtu_probing = false;  //!< 是否探测路径 MTU (RFC 4821)
+  bool pacing = true;  //!< 是否按发送速率分散发出报文
+  //! 监听时使用 SYN cookie (RFC 4987)：不为半连接保存状态，
+  //! 这样建立的连接不使用窗口扩大与时间戳选项
+  bool syn_cookies = false;
+  uint64_t max_pacing_rate = 0;  //!< 发送速率上限 (bytes/s)，0 表示不限
+  CongestionAlgorithm congestion_control = CongestionAlgorithm::Cubic;
 
   std::optional<Wrap32> fixed_isn{};
 };
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+#include "congestion/congestion_control.h"
+
+/**
+ * @brief BBR 拥塞控制 (draft-cardwell-iccrg-bbr-congestion-control, v1)
+ * 由交付速率样本估计瓶颈带宽 (BtlBw) 和最小 RTT (RTprop)，
+ * 以两者之积 (BDP) 决定拥塞窗口，以 BtlBw 决定发送速率，不把丢包当作拥塞信号
+ */
+class Bbr : public CongestionControl {
+  enum class State { Startup, Drain, ProbeBW, ProbeRTT };
+
+  static constexpr double HIGH_GAIN = 2.885;  //!< 2 / ln(2)
+  static constexpr double CWND_GAIN = 2;
+  static constexpr double PACING_GAIN_CYCLE[] = {1.25, 0.75, 1, 1,
+                                                 1,    1,    1, 1};
+  static constexpr uint64_t BW_WINDOW_ROUNDS = 10;
+  static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;
+  static constexpr uint64_t PROBE_RTT_DURATION_MS = 200;
+  static constexpr uint64_t MIN_CWND_SEGMENTS = 4;
+
+  State state_{State::Startup};
+  double pacing_gain_{HIGH_GAIN};
+  double cwnd_gain_{HIGH_GAIN};
+  uint64_t pacing_rate_{};  //!< bytes/s
+
+  //! 近 BW_WINDOW_ROUNDS 轮中的带宽样本 (round, bw)，单调递减
+  std::deque<std::pair<uint64_t, uint64_t>> bw_filter_{};
+  uint64_t round_count_{};
+  uint64_t next_round_delivered_{};
+  bool round_start_{};
+
+  uint64_t min_rtt_ms_{UINT64_MAX};
+  uint64_t min_rtt_stamp_{};
+
+  bool filled_pipe_{};
+  uint64_t full_bw_{};
+  uint64_t full_bw_count_{};
+
+  size_t cycle_index_{};
+  uint64_t cycle_stamp_{};
+
+  uint64_t probe_rtt_done_stamp_{};
+  bool probe_rtt_round_done_{};
+
+  uint64_t prior_cwnd_{};
+  bool packet_conservation_{};
+  uint64_t initial_cwnd_;
+
+  uint64_t bdp(double gain) const;
+  void update_bandwidth(const AckEvent& ack);
+  void check_full_pipe(const AckEvent& ack);
+  void update_state(const AckEvent& ack);
+  void update_min_rtt(const AckEvent& ack);
+  void set_pacing_rate();
+  void set_cwnd(const AckEvent& ack);
+  void enter_probe_bw(uint64_t now_ms);
+  void save_cwnd();
+
+ public:
+  Bbr(uint64_t mss, uint64_t initial_cwnd)
+      : CongestionControl(mss, initial_cwnd), initial_cwnd_(initial_cwnd) {}
+
+  void on_ack(const AckEvent& ack) override;
+  void on_loss(uint64_t in_flight, uint64_t now_ms) override;
+  void on_rto(uint64_t in_flight, uint64_t now_ms) override;
+
+  uint64_t pacing_rate() const override { return pacing_rate_; }
+  std::string_view name() const override { return "bbr"; }
+
+  uint64_t btl_bw() const;  //!< 瓶颈带宽估计 (bytes/s)
+  uint64_t min_rtt_ms() const { return min_rtt_ms_; }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "config/tcp_config.h"
+#include "congestion/delivery_rate.h"
+
+/**
+ * @brief 一次 ACK 带给拥塞控制的信息
+ */
+struct AckEvent {
+  uint64_t acked{};      //!< 本次累计确认推进的序列号数量
+  uint64_t in_flight{};  //!< 确认之后仍在途的序列号数量
+  uint64_t now_ms{};     //!< 当前时间 (ms)
+  bool in_recovery{};    //!< 是否处于快速恢复中
+  uint64_t delivered{};  //!< 连接累计交付的字节数 (含 SACK)
+  RateSample rate{};     //!< 本次 ACK 生成的交付速率样本
+};
+
+/**
+ * @brief 拥塞控制算法的接口，由 Transceiver 在发送前查询
+ * 所有窗口均以序列号 (bytes) 为单位
+ */
+class CongestionControl {
+ protected:
+  uint64_t mss_;                  //!< 最大报文载荷
+  uint64_t cwnd_;                 //!< 拥塞窗口
+  uint64_t ssthresh_{UINT64_MAX};  //!< 慢启动阈值
+
+ public:
+  CongestionControl(uint64_t mss, uint64_t initial_cwnd)
+      : mss_(mss), cwnd_(initial_cwnd) {}
+  virtual ~CongestionControl() = default;
+
+  //! 新数据被确认
+  virtual void on_ack(const AckEvent& ack) = 0;
+  //! 推断出丢包，每轮恢复只调用一次
+  virtual void on_loss(uint64_t in_flight, uint64_t now_ms) = 0;
+  //! 重传超时
+  virtual void on_rto(uint64_t in_flight, uint64_t now_ms) = 0;
+
+  //! 发送速率 (bytes/s)，0 表示不限速
+  virtual uint64_t pacing_rate() const { return 0; }
+
+  virtual std::string_view name() const = 0;
+
+  //! 路径 MTU 探测改变报文大小
+  void set_mss(uint64_t mss) { mss_ = mss; }
+
+  uint64_t mss() const { return mss_; }
+  uint64_t cwnd() const { return cwnd_; }
+  uint64_t ssthresh() const { return ssthresh_; }
+  bool in_slow_start() const { return cwnd_ < ssthresh_; }
+};
+
+//! 根据 TCPConfig::congestion_control 创建拥塞控制算法
+std::unique_ptr<CongestionControl> make_congestion_control(
+    const TCPConfig& cfg, uint64_t mss);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "congestion/congestion_control.h"
+
+/**
+ * @brief CUBIC 拥塞控制 (RFC 9438)
+ * 拥塞避免阶段的窗口是距上次丢包时间的三次函数，
+ * 并以 Reno 友好区间 (W_est) 作为下界
+ */
+class Cubic : public CongestionControl {
+  static constexpr double C = 0.4;
+  static constexpr double BETA = 0.7;
+
+  double w_max_{};           //!< 上次丢包时的窗口 (segments)
+  double w_est_{};           //!< Reno 友好区间估计的窗口 (segments)
+  double k_{};               //!< 窗口增长回 w_max_ 所需的时间 (s)
+  uint64_t epoch_start_{};   //!< 本轮拥塞避免开始的时间 (ms)
+  bool epoch_started_{};
+  double cwnd_fraction_{};   //!< 不足一个 MSS 的窗口增量
+
+  double segments() const { return static_cast<double>(cwnd_) / mss_; }
+  void reduce();
+
+ public:
+  Cubic(uint64_t mss, uint64_t initial_cwnd)
+      : CongestionControl(mss, initial_cwnd) {}
+
+  void on_ack(const AckEvent& ack) override;
+  void on_loss(uint64_t in_flight, uint64_t now_ms) override;
+  void on_rto(uint64_t in_flight, uint64_t now_ms) override;
+
+  std::string_view name() const override { return "cubic"; }
+};
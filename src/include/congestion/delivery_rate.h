@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+/**
+ * @brief 报文发送时记录的交付状态快照
+ */
+struct PacketDeliveryInfo {
+  uint64_t delivered{};      //!< 发送时连接累计交付的字节数
+  uint64_t delivered_ms{};   //!< 发送时最近一次交付的时间
+  uint64_t first_sent_ms{};  //!< 发送时所在发送区间的起始时间
+  uint64_t sent_ms{};        //!< 发送时间
+  bool app_limited{};        //!< 发送时是否受应用层数据量限制
+  bool retransmitted{};      //!< 是否为重传 (Karn: 不参与 RTT 采样)
+};
+
+/**
+ * @brief 一次 ACK 生成的交付速率样本
+ */
+struct RateSample {
+  bool valid{};
+  uint64_t delivery_rate{};    //!< bytes/s
+  uint64_t delivered{};        //!< 采样区间内交付的字节数
+  uint64_t interval_ms{};      //!< 采样区间长度
+  uint64_t prior_delivered{};  //!< 采样报文发送时的累计交付量
+  std::optional<uint64_t> rtt_ms{};
+  bool app_limited{};
+};
+
+/**
+ * @brief 交付速率采样器 (draft-cheng-iccrg-delivery-rate-estimation)
+ * 报文发送时调用 on_send 保存快照，被确认 (累计或 SACK) 时调用
+ * on_delivered，处理完一个 ACK 后调用 generate 得到样本
+ * @note 时间精度受 Transceiver::tick 限制为 1 ms，区间不足 1 ms 时按 1 ms 计
+ */
+class DeliveryRateSampler {
+  uint64_t delivered_{};
+  uint64_t delivered_ms_{};
+  uint64_t first_sent_ms_{};
+  uint64_t app_limited_until_{};  //!< 交付量超过该值后样本不再受应用限制
+
+  /* 当前 ACK 中最晚发送的报文 */
+  bool have_sample_{};
+  uint64_t prior_delivered_{};
+  uint64_t prior_delivered_ms_{};
+  uint64_t send_elapsed_ms_{};
+  bool sample_app_limited_{};
+  std::optional<uint64_t> sample_rtt_ms_{};
+
+  /* 遥测 */
+  uint64_t last_rate_{};
+  std::optional<uint64_t> min_rtt_ms_{};
+
+ public:
+  //! \param idle 发送前网络中是否没有在途数据
+  PacketDeliveryInfo on_send(uint64_t now_ms, bool idle, bool retransmitted);
+
+  void on_delivered(const PacketDeliveryInfo& info, uint64_t bytes,
+                    uint64_t now_ms);
+
+  RateSample generate();
+
+  //! 发送端没有更多数据可发，标记之后的样本受应用限制
+  void set_app_limited(uint64_t in_flight);
+
+  uint64_t delivered() const { return delivered_; }
+  uint64_t delivery_rate() const { return last_rate_; }
+  std::optional<uint64_t> min_rtt_ms() const { return min_rtt_ms_; }
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "congestion/congestion_control.h"
+
+/**
+ * @brief NewReno 拥塞控制 (RFC 5681, RFC 6582)
+ * 慢启动按确认字节数增长 (RFC 3465, L = 2 * MSS)，
+ * 拥塞避免阶段每个 RTT 增加一个 MSS
+ */
+class NewReno : public CongestionControl {
+  uint64_t bytes_acked_{};  //!< 拥塞避免阶段累计确认的字节数
+
+ public:
+  NewReno(uint64_t mss, uint64_t initial_cwnd)
+      : CongestionControl(mss, initial_cwnd) {}
+
+  void on_ack(const AckEvent& ack) override;
+  void on_loss(uint64_t in_flight, uint64_t now_ms) override;
+  void on_rto(uint64_t in_flight, uint64_t now_ms) override;
+
+  std::string_view name() const override { return "newreno"; }
+};
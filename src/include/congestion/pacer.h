@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+/**
+ * @brief 令牌桶发送节奏控制
+ * 令牌按 rate 持续补充，最多积累 burst 字节；桶中令牌足够时报文立即放行，
+ * 否则等待 delay_us 后再尝试。令牌可以被透支，超过 burst 的报文在桶满时放行
+ */
+class Pacer {
+  uint64_t rate_{};   //!< bytes/s，0 表示不限速
+  uint64_t burst_{};  //!< 桶的容量 (bytes)
+  double tokens_{};
+  std::optional<uint64_t> last_us_{};  //!< 上次补充令牌的时间
+
+  void refill(uint64_t now_us);
+
+ public:
+  //! 按旧的速率补充到 now_us 后再修改速率
+  void set_rate(uint64_t now_us, uint64_t rate, uint64_t burst);
+
+  //! 令牌足够时扣除 bytes 并返回 true
+  bool try_send(uint64_t now_us, uint64_t bytes);
+
+  //! try_send 失败后，令牌补充到足够放行 bytes 还需的时间 (us)
+  uint64_t delay_us(uint64_t bytes) const;
+
+  uint64_t rate() const { return rate_; }
+  uint64_t burst() const { return burst_; }
+};
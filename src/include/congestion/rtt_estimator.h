@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+/**
+ * @brief 往返时间估计与重传超时计算 (RFC 6298)
+ * 样本须能对应到唯一的一次发送：未重传的报文 (Karn 算法)，
+ * 或时间戳选项回显的发送时间，由调用方保证
+ */
+class RttEstimator {
+  static constexpr double ALPHA = 1.0 / 8;
+  static constexpr double BETA = 1.0 / 4;
+  static constexpr uint64_t K = 4;
+
+  uint64_t min_rto_ms_;
+  uint64_t max_rto_ms_;
+  uint64_t granularity_ms_;  //!< 时钟粒度 G
+
+  std::optional<double> srtt_ms_{};
+  double rttvar_ms_{};
+  uint64_t rto_ms_;
+
+ public:
+  RttEstimator(uint64_t initial_rto_ms, uint64_t min_rto_ms,
+               uint64_t max_rto_ms, uint64_t granularity_ms);
+
+  //! \param samples_per_rtt 每个 RTT 内预期的样本数；每个 ACK 都测量时
+  //!        按它缩小增益，使估计仍覆盖约 8 个 RTT (RFC 7323 附录 G)
+  void on_sample(uint64_t rtt_ms, uint64_t samples_per_rtt = 1);
+
+  //! 未退避的重传超时
+  uint64_t rto_ms() const { return rto_ms_; }
+  //! 按 2^backoff 退避后的重传超时，不超过上限
+  uint64_t backed_off_rto_ms(unsigned backoff) const;
+
+  std::optional<uint64_t> srtt_ms() const;
+  uint64_t rttvar_ms() const { return static_cast<uint64_t>(rttvar_ms_); }
+};
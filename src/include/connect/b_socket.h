@@ -3,15 +3,19 @@
 #include <atomic>
 #include <cstdint>
 #include <optional>
+#include <queue>
 #include <thread>
 #include <vector>
 
 #include "buffer/string_buffer.h"
 #include "config/tcp_config.h"
 #include "connect/base_socket.h"
+#include "congestion/pacer.h"
+#include "connect/syn_cookie.h"
 #include "connect/tcp_endpoint.h"
 #include "datagram/file_descriptor.h"
 #include "polling/eventpolling.h"
+#include "polling/timer_fd.h"
 #include "tun/tun_adapter.h"
 
 /**
@@ -30,8 +34,17 @@ class TCPSocket : public Socket {
 
   std::optional<TCPEndpoint> _tcp{};  //!< TCP状态机
 
+  //! 以 SYN cookie 监听时使用，握手完成前不为任何对端保存状态
+  std::optional<SynCookies> _syn_cookies{};
+
+  //! 监听中收到的报文：回复 SYN，或按确认的 cookie 建立连接
+  void _cookie_handshake();
+
   std::queue<TCPSegment> outgoing_segments_{};  //!< 待发送数据包的队列
 
+  Pacer _pacer{};            //!< 按发送速率放行队列中的数据包
+  TimerFD _pacing_timer{};  //!< 令牌不足时，到期后继续发送
+
   EventEpoll _eventloop;  //!< 轮询事件
 
   void _tcp_loop(const std::function<bool()>& condition);
@@ -40,6 +53,9 @@ class TCPSocket : public Socket {
 
   std::thread _tcp_thread{};
 
+  //! 连接结束时的统计，由 _tcp_main 在释放状态机前保存
+  std::optional<TCPStats> _final_stats{};
+
   TCPSocket(std::pair<FileDescriptor, FileDescriptor> data_socket_pair,
             AdaptT&& datagram_interface, EventEpoll&& eventloop);
 
@@ -58,6 +74,9 @@ class TCPSocket : public Socket {
 
   void wait_until_closed();
 
+  //! 连接结束后的统计，须在 wait_until_closed 之后读取
+  const std::optional<TCPStats>& stats() const { return _final_stats; }
+
   void connect(const TCPConfig& c_tcp, const FdAdapterConfig& c_ad);
 
   void listen_and_accept(const TCPConfig& c_tcp, const FdAdapterConfig& c_ad);
@@ -2,6 +2,8 @@
 
 #include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "buffer/stream_buffer.h"
 
@@ -13,11 +15,21 @@ class Reassembler {
   void insert(uint64_t first_index, std::string data, bool is_last_substring,
               Writer& output);
 
+  //! 没有乱序数据、且 data 恰好从 first_index 接续时直接追加到 output，
+  //! 不复制数据；否则返回 false，由调用方使用 insert
+  bool push_in_order(uint64_t first_index, const Buffer& data, Writer& output);
+
   uint64_t bytes_pending() const;  //!< Reassembler 内已经存放多少数据
 
+  //! 乱序到达、尚未提交的数据区间 [first, last)，用于生成 SACK 块
+  //! 包含最近一次插入数据的区间排在最前 (RFC 2018)，其余按序排列
+  std::vector<std::pair<uint64_t, uint64_t>> pending_ranges(
+      size_t max_ranges) const;
+
  private:
   std::map<size_t, std::string> _unassembled_strings;
   size_t _last_string_end;
   size_t _last_popped_end;
+  size_t _last_inserted_index{};  //!< 最近一次乱序插入的位置
   void _push_availables(Writer& output, size_t index);
 };
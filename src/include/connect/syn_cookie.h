@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include "config/tcp_config.h"
+#include "connect/tcp_endpoint.h"
+#include "datagram/tcp_message.h"
+#include "datagram/wrapping_integers.h"
+#include "tun/tun_adapter.h"
+
+/**
+ * @brief SYN cookie (RFC 4987 3.6)
+ * 被动打开时不为半连接保存任何状态：SYN-ACK 的 ISN 编码了时间、
+ * 对端的 MSS 与 SACK-Permitted，以及它们与四元组的带密钥哈希；
+ * 第三次握手的 ACK 确认了有效的 cookie，才按其中的信息重建连接
+ */
+class SynCookies {
+  TCPConfig _cfg;                //!< 接受的连接使用的配置
+  std::array<uint64_t, 2> _key;  //!< SipHash-2-4 的密钥，每个实例随机生成
+
+  //! 时间、选项与四元组、对端 ISN 的哈希，截取 cookie 中能放下的位数
+  uint32_t hash(const FourTuple& tuple, Wrap32 peer_isn, uint32_t count,
+                uint32_t options) const;
+
+  //! 以 cookie 为 ISN 的新连接，处理按 cookie 中的选项还原的对端 SYN
+  TCPEndpoint restore(Wrap32 peer_isn, uint32_t cookie) const;
+
+ public:
+  explicit SynCookies(const TCPConfig& cfg);
+
+  //! 回复对端 SYN 的 SYN-ACK，它的 ISN 就是 cookie
+  TCPSegment syn_ack(const FourTuple& tuple, const TCPSegment& syn,
+                     uint64_t now_ms) const;
+
+  //! 校验第三次握手的 ACK，cookie 有效时重建连接并让它处理这个 ACK
+  std::optional<TCPEndpoint> accept(const FourTuple& tuple, TCPSegment ack,
+                                    uint64_t now_ms) const;
+};
@@ -12,7 +12,7 @@
  */
 class TCPEndpoint {
     TCPConfig cfg_;  //!< 配置内容
-    Transceiver transceiver_{cfg_.rt_timeout, cfg_.fixed_isn};  //!< 收发器
+    Transceiver transceiver_{cfg_};  //!< 收发器
     Reassembler reassembler_{};  //!< 流重组器
 
     StreamBuffer outbound_stream_{cfg_.send_capacity},
@@ -20,21 +20,182 @@ class TCPEndpoint {
 
     bool need_send_{};
 
+    /* 延迟确认 (RFC 1122 4.2.3.2, RFC 5681 4.2) */
+    uint64_t unacked_segments_{};  //!< 收到后尚未确认的数据报文数
+    std::optional<uint64_t> ack_delay_elapsed_{};  //!< 延迟确认已等待的时间
+    uint64_t acks_saved_{};  //!< 合并进同一个 ACK 而省去的 ACK 数
+
+    //! 收到一个数据报文后，决定立即确认还是延迟确认
+    void schedule_ack(bool immediate) {
+        unacked_segments_ += 1;
+        if (immediate || !cfg_.ack_delay_ms ||
+            unacked_segments_ >= cfg_.ack_every) {
+            need_send_ = true;
+        } else if (!ack_delay_elapsed_) {
+            ack_delay_elapsed_ = 0;
+        }
+    }
+
+    uint64_t segments_received_{};
+    uint64_t header_predicted_{};  //!< 命中首部预测的报文数
+
+    /**
+     * @brief 接收缓冲区的自动调整 (类似 Linux tcp_rcv_space_adjust)
+     * 每个 RTT 统计应用读取的字节数，把缓冲区调整为它的两倍，
+     * 使发送方在慢启动中仍能翻倍；空闲后缩回初始大小
+     */
+    struct RcvSpace {
+        uint64_t start_ms{};      //!< 本次统计的起点
+        uint64_t start_popped{};  //!< 起点时应用已读取的字节数
+        uint64_t space{};         //!< 一个 RTT 内读取的最大字节数
+        uint64_t idle_ms{};       //!< 没有数据到达的时间
+        uint64_t target;          //!< 希望的缓冲区大小
+    };
+
+    uint64_t time_ms_{};
+    RcvSpace rcv_space_{.target = cfg_.recv_capacity};
+
+    //! 已通告窗口的右边界 (流中的位置)，发出第一个 ACK 之前为空
+    std::optional<uint64_t> window_edge_{};
+
+    //! 窗口右边界至少移动这么多才通告：min(缓冲区的一半, MSS)
+    uint64_t window_update_threshold() const {
+        return std::min(inbound_stream_.writer().capacity() / 2,
+                        uint64_t{cfg_.mss});
+    }
+
+    //! 要发出的确认；接收端糊涂窗口避免 (RFC 1122 4.2.3.3)：
+    //! 右边界的增量不足阈值时仍通告原来的边界
+    TCPReceiverMessage receiver_message() const {
+        const Writer& inbound = inbound_stream_.writer();
+        auto msg = transceiver_.send_ack(reassembler_, inbound);
+        const uint64_t pushed = inbound.bytes_pushed();
+        if (msg.ackno && window_edge_ && window_edge_.value() >= pushed &&
+            pushed + msg.window_size < window_edge_.value() +
+                                           window_update_threshold()) {
+            msg.window_size =
+                static_cast<uint32_t>(window_edge_.value() - pushed);
+        }
+        return msg;
+    }
+
+    //! 应用读取后窗口是否值得主动更新：已通告的剩余窗口不到缓冲区的一半，
+    //! 且新窗口至少是它的两倍 (类似 Linux tcp_cleanup_rbuf)
+    bool window_update_due() const {
+        const Writer& inbound = inbound_stream_.writer();
+        if (!window_edge_ || inbound.is_closed()) {
+            return false;
+        }
+        const auto msg = receiver_message();
+        const uint64_t pushed = inbound.bytes_pushed();
+        const uint64_t advertised =
+            window_edge_.value() > pushed ? window_edge_.value() - pushed : 0;
+        return 2 * advertised <= inbound.capacity() &&
+               msg.window_size >= 2 * advertised &&
+               pushed + msg.window_size > window_edge_.value();
+    }
+
+    //! 每个 RTT 调整一次接收缓冲区
+    void adjust_rcv_space() {
+        const auto srtt = transceiver_.srtt_ms();
+        const uint64_t elapsed = time_ms_ - rcv_space_.start_ms;
+        if (!srtt || elapsed < std::max(srtt.value(), uint64_t{1})) {
+            return;
+        }
+
+        const Reader& inbound = inbound_stream_.reader();
+        const uint64_t copied =
+            inbound.bytes_popped() - rcv_space_.start_popped;
+        if (copied > rcv_space_.space) {
+            rcv_space_.space = copied;
+            rcv_space_.target =
+                std::min(std::max(rcv_space_.target, 2 * copied),
+                         uint64_t{cfg_.max_recv_capacity});
+        }
+        if (!copied && !inbound.bytes_buffered()) {
+            rcv_space_.idle_ms += elapsed;
+            if (rcv_space_.idle_ms >= TCPConfig::RCV_SPACE_IDLE_MS) {
+                rcv_space_.space = 0;
+                rcv_space_.target = cfg_.recv_capacity;
+            }
+        } else {
+            rcv_space_.idle_ms = 0;
+        }
+        rcv_space_.start_ms = time_ms_;
+        rcv_space_.start_popped = inbound.bytes_popped();
+
+        // 缩小时不收回已通告的窗口 (RFC 7323 2.4)，随应用读取逐步缩小
+        const uint64_t edge = window_edge_.value_or(0);
+        const uint64_t advertised =
+            edge > inbound.bytes_popped() ? edge - inbound.bytes_popped() : 0;
+        inbound_stream_.writer().set_capacity(
+            std::max(rcv_space_.target, advertised));
+    }
+
+    /**
+     * @brief 发送缓冲区的自动调整 (类似 Linux tcp_sndbuf_expand)
+     * 在途的数据直到确认前都占用发送缓冲区，把它扩大到可发送窗口
+     * min(cwnd, 对端窗口) 的两倍，使窗口内的数据全部在途时应用仍能写入
+     * 下一个窗口；只增不减
+     */
+    void expand_snd_buf() {
+        const uint64_t window =
+            std::min(transceiver_.congestion_control().cwnd(),
+                     transceiver_.peer_window());
+        const uint64_t target =
+            std::min(2 * window, uint64_t{cfg_.max_send_capacity});
+        Writer& outbound = outbound_stream_.writer();
+        if (target > outbound.capacity()) {
+            outbound.set_capacity(target);
+        }
+    }
+
    public:
     explicit TCPEndpoint(const TCPConfig& cfg) : cfg_(cfg) {}
 
     Writer& outbound_writer() { return outbound_stream_.writer(); }
     Reader& inbound_reader() { return inbound_stream_.reader(); }
 
-    void push() { transceiver_.push(outbound_stream_.reader()); };
+    //! 分段时为之后的 ACK 要携带的 SACK 块留出空间
+    void push() {
+        const size_t sack_blocks =
+            reassembler_.bytes_pending()
+                ? receiver_message().sack_blocks.size()
+                : 0;
+        transceiver_.push(outbound_stream_.reader(), sack_blocks);
+    };
+    //! 类似 TCP_CORK：开启后不足 MSS 的数据等到凑满或超时才发送
+    void set_cork(bool cork) {
+        transceiver_.set_cork(cork);
+        push();
+    }
     void tick(uint64_t ms_since_last_tick) {
         transceiver_.tick(ms_since_last_tick);
+        time_ms_ += ms_since_last_tick;
+        if (cfg_.rcvbuf_autotune) {
+            adjust_rcv_space();
+        }
+        if (ack_delay_elapsed_) {
+            ack_delay_elapsed_.value() += ms_since_last_tick;
+            need_send_ |= ack_delay_elapsed_.value() >= cfg_.ack_delay_ms;
+        }
+    }
+
+    //! 距最近一个计时器 (含延迟确认) 到期的时间，没有计时器时为空
+    std::optional<uint64_t> next_timeout_ms() const {
+        auto next = transceiver_.next_timeout_ms();
+        if (ack_delay_elapsed_) {
+            const uint64_t elapsed = ack_delay_elapsed_.value();
+            const uint64_t left =
+                cfg_.ack_delay_ms > elapsed ? cfg_.ack_delay_ms - elapsed : 0;
+            next = std::min(next.value_or(left), left);
+        }
+        return next;
     }
 
     //! 发送的数据包是否包含ACK
     bool has_ackno() const {
-        return transceiver_.send_ack(inbound_stream_.writer())
-            .ackno.has_value();
+        return receiver_message().ackno.has_value();
     }
 
     //! 信道是否活跃(若两端都关闭了,返回false)
@@ -56,23 +217,71 @@ class TCPEndpoint {
             return;
         }
 
-        transceiver_.receive_ack(seg.receiver_message);
+        // PAWS 拒绝的旧报文整个丢弃，只回复 ACK
+        if (transceiver_.paws_reject(seg.sender_message)) {
+            need_send_ = true;
+            return;
+        }
+
+        segments_received_ += 1;
+        if (transceiver_.receive_predicted(seg.sender_message,
+                                           seg.receiver_message, reassembler_,
+                                           inbound_stream_.writer())) {
+            header_predicted_ += 1;
+            if (cfg_.sndbuf_autotune) {
+                expand_snd_buf();
+            }
+            if (!seg.sender_message.payload.empty()) {
+                schedule_ack(false);
+            }
+            return;
+        }
+
+        transceiver_.receive_ack(seg.receiver_message,
+                                 seg.sender_message.sequence_length() == 0);
+        if (cfg_.sndbuf_autotune) {
+            expand_snd_buf();
+        }
 
-        need_send_ |= (seg.sender_message.sequence_length() > 0);
         const auto our_ackno =
-            transceiver_.send_ack(inbound_stream_.writer()).ackno;
+            transceiver_.send_ack(reassembler_, inbound_stream_.writer())
+                .ackno;
         need_send_ |= (our_ackno.has_value() &&
                        seg.sender_message.seqno + 1 == our_ackno.value());
 
+        const uint64_t length = seg.sender_message.sequence_length();
+        const bool syn_or_fin =
+            seg.sender_message.SYN || seg.sender_message.FIN;
+        const bool had_gap = reassembler_.bytes_pending() > 0;
+        const uint64_t pushed = inbound_stream_.writer().bytes_pushed();
+
         transceiver_.receive_isn(std::move(seg.sender_message), reassembler_,
                                  inbound_stream_.writer());
+
+        if (length > 0) {
+            // 乱序、重复或窗口外的报文不推进 ackno，与填补空洞的报文一样
+            // 需要立即确认，供对端的快速重传与 SACK 使用
+            const bool advanced =
+                inbound_stream_.writer().bytes_pushed() != pushed;
+            schedule_ack(syn_or_fin || !advanced || had_gap);
+        }
+    }
+
+    //! SYN cookie 重建的连接：SYN-ACK 早已由监听方无状态地发出，
+    //! 这里只记为已发送，也不用它测量 RTT
+    void assume_syn_ack_sent() {
+        while (maybe_send()) {
+        }
+        transceiver_.forgo_rtt_samples();
     }
 
     std::optional<TCPSegment> maybe_send() {
-        auto receiver_msg = transceiver_.send_ack(inbound_stream_.writer());
+        need_send_ |= window_update_due();
+        auto receiver_msg = receiver_message();
 
         if (receiver_msg.ackno.has_value()) {
-            push();
+            transceiver_.push(outbound_stream_.reader(),
+                              receiver_msg.sack_blocks.size());
         }
 
         auto sender_msg = transceiver_.maybe_send();
@@ -83,6 +292,23 @@ class TCPEndpoint {
 
         need_send_ = false;
 
+        if (sender_msg.has_value() && receiver_msg.ackno.has_value()) {
+            // 载荷与选项合计不超过 MSS，放不下的 SACK 块由随后的 ACK 携带
+            const size_t fit = transceiver_.sack_blocks_fit(sender_msg.value());
+            while (receiver_msg.sack_blocks.size() > fit) {
+                receiver_msg.sack_blocks.pop_back();
+                need_send_ = true;
+            }
+            // 这个 ACK 一并确认了所有等待中的报文
+            if (unacked_segments_ > 1) {
+                acks_saved_ += unacked_segments_ - 1;
+            }
+            unacked_segments_ = 0;
+            ack_delay_elapsed_.reset();
+            window_edge_ = inbound_stream_.writer().bytes_pushed() +
+                           receiver_msg.window_size;
+        }
+
         if (sender_msg.has_value()) {
             return TCPSegment{sender_msg.value(), receiver_msg,
                               outbound_stream_.reader().has_error() or
@@ -93,4 +319,14 @@ class TCPEndpoint {
     }
 
     const Transceiver& transceiver() const { return transceiver_; }
+
+    TCPStats stats() const {
+        TCPStats stats = transceiver_.stats();
+        stats.acks_saved = acks_saved_;
+        stats.segments_received = segments_received_;
+        stats.header_predicted = header_predicted_;
+        stats.rcv_buffer = inbound_stream_.writer().capacity();
+        stats.snd_buffer = outbound_stream_.writer().capacity();
+        return stats;
+    }
 };
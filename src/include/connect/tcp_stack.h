@@ -0,0 +1,323 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "config/tcp_config.h"
+#include "congestion/pacer.h"
+#include "connect/base_socket.h"
+#include "connect/syn_cookie.h"
+#include "connect/tcp_endpoint.h"
+#include "polling/epoll_fd.h"
+#include "polling/event_fd.h"
+#include "polling/eventpolling.h"
+#include "polling/timer_fd.h"
+#include "tun/tun_adapter.h"
+#include "utils/spsc_queue.h"
+
+/**
+ * @brief TCPStack 中一条连接在应用一端的 socket
+ * 读写的数据经 socketpair 交给栈的线程
+ */
+class TCPStackSocket : public Socket {
+  std::shared_future<void> _closed;  //!< 连接结束、被栈移除时就绪
+
+ public:
+  TCPStackSocket(Socket&& app_side, std::shared_future<void> closed);
+
+  //! 关闭应用一端，等待连接结束
+  void wait_until_closed();
+};
+
+/**
+ * @brief 监听 socket 的队列，由栈的线程和调用 accept() 的线程共享
+ */
+struct ListenQueue {
+  TCPConfig cfg;
+  uint32_t address;  //!< 监听的本端地址，0 表示任意地址
+  size_t backlog;    //!< 半连接与全连接队列各自的上限
+
+  //! 配置要求时，用 SYN cookie 代替半连接队列
+  std::optional<SynCookies> cookies{};
+
+  /* 以下由栈的各个分片更新 */
+  std::atomic<size_t> syn_received{};  //!< 收到 SYN、尚未完成握手的连接数
+  std::atomic<uint64_t> syns_dropped{};  //!< 队列已满而丢弃的 SYN
+  std::atomic<uint64_t> cookies_rejected{};  //!< 确认了无效 cookie 的 ACK
+
+  std::mutex mutex{};
+  std::condition_variable ready{};
+  std::deque<TCPStackSocket> established{};  //!< 握手完成、等待 accept()
+  std::atomic_bool closed{false};
+
+  //! 收到一个 SYN：两个队列都未满时接受，不使用 cookie 时占用半连接队列
+  //! 的一个位置 (握手完成或失败时释放)；已满时计入 syns_dropped，对端稍后重传
+  bool admit_syn();
+
+  //! 全连接队列是否已满
+  bool accept_queue_full();
+};
+
+/**
+ * @brief TCPStack 中的监听 socket，析构时停止监听
+ */
+class TCPStackListener {
+  std::shared_ptr<ListenQueue> _queue;
+
+ public:
+  explicit TCPStackListener(std::shared_ptr<ListenQueue> queue)
+      : _queue(std::move(queue)) {}
+
+  //! 等待并取出一条握手完成的连接
+  TCPStackSocket accept();
+
+  //! 停止监听，队列中尚未取出的连接随之关闭
+  void close();
+
+  ~TCPStackListener() { close(); }
+
+  //!@{
+  TCPStackListener(const TCPStackListener&) = delete;
+  TCPStackListener(TCPStackListener&&) = default;
+  TCPStackListener& operator=(const TCPStackListener&) = delete;
+  TCPStackListener& operator=(TCPStackListener&&) = default;
+  //!@}
+};
+
+/**
+ * @brief 多连接的 TCP 协议栈
+ * 连接按四元组的哈希分给若干分片 (类似网卡的 RSS)，每个分片在自己的线程中
+ * 运行一个事件循环，独占它的连接；收到的报文在分片内按四元组在哈希表中
+ * 找到所属的 TCPEndpoint
+ */
+class TCPStack {
+ private:
+  /**
+   * @brief 栈中的一条连接
+   */
+  struct Connection {
+    FdAdapterConfig addresses;  //!< source 为本端，destination 为对端
+    TCPEndpoint tcp;
+    Socket data;  //!< socketpair 中栈的一端
+
+    std::queue<TCPSegment> outgoing{};  //!< 待发送数据包的队列
+    Pacer pacer{};
+    bool sending{};  //!< 是否在所属分片的 senders 中
+
+    bool inbound_shutdown{};
+    bool outbound_shutdown{};
+
+    /* data 在所属分片的 epoll 中的状态 */
+    bool watched{};     //!< 是否在 epoll 中
+    uint32_t events{};  //!< 关注的事件
+    bool hung_up{};     //!< 应用一端已挂断 (EPOLLHUP)
+
+    /* 计时器：连接只在有事件或计时器到期时 tick */
+    uint64_t last_tick_ms{};
+    std::optional<uint64_t> deadline_ms{};  //!< 在分片的计时器堆中的期限
+    bool touched{};  //!< 是否在分片的 touched 中
+
+    std::promise<void> closed{};
+
+    //! 被动打开、尚未完成握手时，所属的监听队列和暂存的应用一端
+    std::shared_ptr<ListenQueue> listener{};
+    std::optional<TCPStackSocket> app{};
+
+    Connection(const TCPConfig& cfg, const FdAdapterConfig& ad, Socket&& s)
+        : addresses(ad), tcp(cfg), data(std::move(s)) {}
+  };
+
+  //! 一个报文和它所属连接的四元组
+  using Flow = std::pair<FourTuple, TCPSegment>;
+
+  //! 计时器堆中的一项；连接的期限提前后，旧的项在到期时被忽略
+  struct Timer {
+    uint64_t deadline_ms;
+    FourTuple tuple;
+
+    bool operator>(const Timer& other) const {
+      return deadline_ms > other.deadline_ms;
+    }
+  };
+
+  /**
+   * @brief 栈的一个分片：一个线程和它的事件循环、tun 文件描述符，
+   * 以及四元组哈希到它的所有连接。每个分片读写多队列 tun 的一个队列，
+   * 内核按流分发；分片之间只在建立连接时交接，以及经无锁队列转交内核
+   * 尚未学到所在队列的流的报文，数据路径上没有共享的锁
+   */
+  struct Shard {
+    size_t index;
+    TCPOverIPv4OverTunFdAdapter adapter;
+
+    std::unordered_map<FourTuple, std::unique_ptr<Connection>, FourTupleHash>
+        connections{};
+
+    //! 有数据包待发送的连接，按加入的顺序轮流发送
+    std::vector<Connection*> senders{};
+    TimerFD pacing_timer{};  //!< 所有连接的令牌都不足时，到期后继续发送
+
+    //! 其他线程打开、等待本分片注册的连接
+    std::mutex pending_mutex{};
+    std::vector<std::unique_ptr<Connection>> pending{};
+    std::atomic_bool has_pending{false};
+
+    //! 其他分片读到、属于本分片的报文，每个来源分片一个队列
+    std::vector<std::unique_ptr<SpscQueue<Flow>>> inbox{};
+    //! inbox 中有报文或 pending 中有连接时由其他线程通知，唤醒事件循环
+    EventFD wakeup{};
+    std::atomic<uint64_t> steered{};  //!< 转交给其他分片的报文数
+    std::atomic<uint64_t> steer_drops{};  //!< 目标队列已满而丢弃的报文数
+
+    //! 所有连接在栈一端的 socket，事件循环中的一条规则只服务就绪的连接
+    EpollFD sockets{};
+    //! 各连接最近的计时器期限；只有到期的连接才会被 tick
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers{};
+    //! 本轮状态有变化、需要检查是否已经结束的连接
+    std::vector<Connection*> touched{};
+
+    EventEpoll eventloop{};
+
+    std::thread thread{};
+
+    Shard(size_t i, TunFD&& tun) : index(i), adapter(std::move(tun)) {}
+  };
+
+  std::vector<std::unique_ptr<Shard>> _shards{};
+  bool _multi_queue{};  //!< tun 是否多队列，每个分片读写自己的队列
+  std::atomic<size_t> _connection_count{};
+
+  //! 按本端端口索引的监听队列，只在收到新连接的报文时查找
+  std::mutex _listeners_mutex{};
+  std::unordered_map<uint16_t, std::shared_ptr<ListenQueue>> _listeners{};
+
+  std::atomic_bool _abort{false};
+
+  Shard& _shard_of(const FourTuple& tuple) {
+    return *_shards[shard_index(tuple, _shards.size())];
+  }
+
+  //! 把事件循环的规则加入分片
+  void _setup_shard(Shard& shard);
+
+  void _shard_main(Shard& shard);
+
+  //! 读取一批报文，属于其他分片的转交出去
+  void _receive_batch(Shard& shard);
+
+  //! 在所属的分片中处理一个报文
+  void _deliver(Shard& shard, Flow flow);
+
+  //! 创建一条连接和应用一端的 socket
+  std::pair<std::unique_ptr<Connection>, TCPStackSocket> _make_connection(
+      const TCPConfig& c_tcp, const FdAdapterConfig& c_ad);
+
+  //! 在分片的线程中注册连接，把它的 socket 加入 epoll；
+  //! 主动打开时发出 SYN，被动打开时处理收到的 SYN
+  void _register(Shard& shard, std::unique_ptr<Connection> conn,
+                 std::optional<TCPSegment> syn = {});
+
+  //! 监听该四元组本端地址的队列，没有时为空
+  std::shared_ptr<ListenQueue> _find_listener(const FourTuple& tuple);
+
+  //! 不属于任何连接的 SYN：交给监听该端口的队列
+  void _accept_syn(Shard& shard, const FourTuple& tuple, TCPSegment syn);
+
+  //! 不属于任何连接的 ACK：可能确认了监听方发出的 SYN cookie
+  void _accept_cookie(Shard& shard, const FourTuple& tuple, TCPSegment ack);
+
+  //! 被动打开的连接完成握手后，移入监听队列等待 accept()
+  void _check_established(Connection& conn);
+
+  //! 把连接的时钟推进到 now_ms
+  static void _advance(Connection& conn, uint64_t now_ms);
+
+  //! 连接的状态变化之后：收集待发送的数据包，更新 epoll 中关注的事件
+  //! 和计时器期限，并留待检查是否已经结束
+  void _touch(Shard& shard, Connection& conn);
+  static void _mark_touched(Shard& shard, Connection& conn);
+
+  //! 按连接的状态修改它在 epoll 中关注的事件
+  static void _watch(Shard& shard, Connection& conn);
+
+  //! 把连接最近的计时器期限加入堆中
+  static void _schedule(Shard& shard, Connection& conn);
+
+  //! tick 计时器已经到期的连接
+  void _expire_timers(Shard& shard, uint64_t now_ms);
+
+  //! 服务 socket 就绪的连接
+  void _serve_sockets(Shard& shard);
+
+  //! 从应用读出数据，写入出站的字节流
+  static void _pull_from_app(Connection& conn);
+
+  //! 把入站字节流中的数据写给应用
+  static void _push_to_app(Connection& conn);
+
+  //! 移除本轮状态有变化的连接中已经结束的
+  void _reap(Shard& shard);
+
+  void _collect_segments(Shard& shard, Connection& conn);
+
+  //! 依次发送各连接的数据包；令牌不足的连接留到定时器到期
+  void _send_segments(Shard& shard);
+
+ public:
+  static constexpr size_t STEER_QUEUE_SIZE = 4096;  //!< 分片间队列的容量
+
+  //! 四元组所属的分片：哈希的高位按分片数等比缩放
+  static size_t shard_index(const FourTuple& tuple, size_t shards);
+
+  //! \param[in] devname 所有连接共用的 tun 设备
+  //! \param[in] shards 分片 (线程) 数；多于一个时 tun 必须以多队列模式
+  //! 创建，否则只使用一个分片
+  //! \param[in] offload 是否启用 tun 的校验和与 TSO 卸载 (IFF_VNET_HDR)：
+  //! 连续的报文合并为超级报文写入，读取内核合并的大报文
+  explicit TCPStack(const std::string& devname, size_t shards = 1,
+                    bool offload = false);
+
+  ~TCPStack();
+
+  //! 打开一条连接 (主动打开)，不等待握手完成
+  //! \param[in] c_tcp TCP连接配置
+  //! \param[in] c_ad 本端与对端的地址
+  TCPStackSocket connect(const TCPConfig& c_tcp, const FdAdapterConfig& c_ad);
+
+  //! 在本端地址上监听 (被动打开)
+  //! \param[in] c_tcp 每条接受的连接使用的配置
+  //! \param[in] local 本端地址，地址为 "0" 时接受任意目的地址
+  //! \param[in] backlog 半连接与全连接队列各自的上限
+  TCPStackListener listen(const TCPConfig& c_tcp, const Address& local,
+                          size_t backlog = TCPConfig::LISTEN_BACKLOG_DFLT);
+
+  //! 当前的连接数
+  size_t connections() const { return _connection_count; }
+
+  size_t shards() const { return _shards.size(); }
+
+  bool multi_queue() const { return _multi_queue; }
+
+  //! 读到后转交给其他分片的报文总数，只在内核尚未学到流所在的队列
+  //! (本端还没有从该队列发出过报文) 时发生
+  uint64_t steered() const;
+
+  //!@{
+  TCPStack(const TCPStack&) = delete;
+  TCPStack(TCPStack&&) = delete;
+  TCPStack& operator=(const TCPStack&) = delete;
+  TCPStack& operator=(TCPStack&&) = delete;
+  //!@}
+};
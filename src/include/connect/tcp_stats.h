@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief 一条 TCP 连接的运行状态快照，用于遥测和调试输出
+ */
+struct TCPStats {
+  std::string_view congestion_control{};  //!< 拥塞控制算法
+  uint64_t cwnd{};                        //!< 拥塞窗口 (bytes)
+  uint64_t ssthresh{};                    //!< 慢启动阈值 (bytes)
+  uint64_t pacing_rate{};    //!< 发送速率 (bytes/s)，0 表示不限速
+  uint64_t pacing_burst{};   //!< 按发送速率发出时允许的突发 (bytes)
+  uint64_t delivery_rate{};  //!< 最近的交付速率样本 (bytes/s)
+  std::optional<uint64_t> min_rtt_ms{};  //!< 观测到的最小 RTT
+  std::optional<uint64_t> srtt_ms{};     //!< 平滑 RTT (RFC 6298)
+  uint64_t rttvar_ms{};                  //!< RTT 偏差
+  uint64_t rto_ms{};                     //!< 当前的重传时间 (含退避)
+  uint64_t bytes_delivered{};            //!< 累计被确认的字节数
+  uint64_t segments_retransmitted{};     //!< 累计重传的报文数
+  uint64_t loss_probes{};                //!< 累计发送的尾部丢包探测
+  uint64_t mss{};                        //!< 当前的报文最大载荷 (bytes)
+  uint64_t mtu_probes{};                 //!< 累计发送的路径 MTU 探测
+  uint64_t window_probes{};              //!< 累计发送的零窗口探测
+  uint64_t acks_saved{};                 //!< 延迟确认省去的 ACK 数
+  uint64_t rcv_buffer{};                 //!< 当前的接收缓冲区大小 (bytes)
+  uint64_t snd_buffer{};                 //!< 当前的发送缓冲区大小 (bytes)
+  uint64_t segments_received{};          //!< 累计收到的报文数
+  uint64_t header_predicted{};           //!< 其中命中首部预测的报文数
+
+  std::string to_string() const;
+};
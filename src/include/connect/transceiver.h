@@ -1,10 +1,15 @@
 #pragma once
 
-#include <map>
+#include <deque>
+#include <memory>
 #include <optional>
-#include <queue>
 
 #include "buffer/stream_buffer.h"
+#include "config/tcp_config.h"
+#include "congestion/congestion_control.h"
+#include "congestion/delivery_rate.h"
+#include "congestion/rtt_estimator.h"
+#include "connect/tcp_stats.h"
 #include "datagram/tcp_message.h"
 #include "reassembler.h"
 
@@ -12,42 +17,209 @@
  * @brief 收发器
  */
 class Transceiver {
+    TCPConfig cfg_;  //!< 配置内容
+
     /* 发送端 */
    private:
+    /**
+     * @brief 重传队列中的报文及其 SACK 记分板状态 (RFC 6675)
+     */
+    struct OutstandingSegment {
+        uint64_t seqno{};  //!< 绝对序列号
+        TCPSenderMessage message;
+        bool queued{};         //!< 等待重传
+        bool sacked{};         //!< 已被 SACK 块确认
+        bool lost{};           //!< 已被推断为丢失
+        bool retransmitted{};  //!< 本轮恢复中已经重传过
+        uint16_t transmissions{};      //!< 已发送的次数
+        PacketDeliveryInfo delivery{};  //!< 最近一次发送时的交付状态
+    };
+
+    /**
+     * @brief 路径 MTU 的搜索区间 (RFC 4821)，以报文载荷计
+     */
+    struct MtuSearch {
+        uint64_t low{};   //!< 已确认能通过路径的大小
+        uint64_t high{};  //!< 尚未被否定的大小
+        uint64_t max{};   //!< 握手协商的 MSS，重新探测时的上限
+        std::optional<uint64_t> probe_seqno{};  //!< 在途探测报文的序列号
+        uint64_t probe_size{};
+        std::optional<uint64_t> done_ms{};  //!< 搜索收敛的时间
+    };
+
+    /**
+     * @brief RACK 状态：最近发送的已交付报文 (RFC 8985)
+     */
+    struct RackState {
+        std::optional<uint64_t> rtt_ms{};  //!< 该报文的 RTT，尚无交付时为空
+        uint64_t xmit_ms{};                //!< 该报文的发送时间
+        uint64_t end_seq{};                //!< 该报文的结束序列号
+        uint64_t fack{};                   //!< 已交付的最高序列号
+        bool reordering_seen{};            //!< 是否观测到乱序
+        std::optional<uint64_t> reorder_deadline_ms{};  //!< 乱序等待的截止时间
+    };
+
     Wrap32 send_isn_;
 
-    uint64_t initial_RTO_ms_;  //!< 重传时间
-    uint16_t _rto_factor{1};
+    RttEstimator rtt_;        //!< RTT 估计与重传时间
+    unsigned _rto_backoff{};  //!< 重传时间的指数退避次数
     uint64_t _ms_since_last_ticked{};
 
     uint64_t consecutive_retransmissions_{};  //!< 重传次数
 
-    std::queue<uint64_t> isn_send_queue_;            //!< 待发送的isn
-    std::map<uint64_t, TCPSenderMessage> _messages;  //!< 待发送的数据包队列
-    uint64_t _popped_bytes{};  // use bytes_popped() to get abs seqno
+    //! 重传队列：报文按序列号追加，累计确认从队首弹出
+    std::deque<OutstandingSegment> _messages;
+    size_t _send_index{};          //!< 第一个尚未发送的报文的下标
+    size_t _retransmits_queued{};  //!< 等待重传的报文数量
+    uint64_t _seqnos_in_flight{};  //!< _messages 中序列号的总数
+    uint64_t _sacked_seqnos{};     //!< 其中已被 SACK 的序列号数
+    //! 已经分段的流字节数；数据在被确认前一直保留在发送流中，
+    //! 报文的载荷是流中数据的切片
+    uint64_t _segmented_bytes{};
     bool _started{};
     bool _finished{};
     uint64_t _last_ackno{};
-    uint64_t _window_size{1};  // as said in FAQ (for back off RTO)
+    uint64_t _window_size{1};  //!< 对端的接收窗口，握手前允许发送 SYN
+    //! 报文的最大载荷：双方 MSS 的较小值，减去每个报文都带的选项
+    uint64_t _mss;
+
+    std::optional<uint64_t> _recovery_point{};  //!< 丢包恢复结束的序列号
+    bool _fast_recovery{};  //!< 恢复是否由丢包推断 (而非超时) 触发
+    uint64_t _dup_acks{};   //!< 连续的重复 ACK 数量
+    bool _sack_seen{};      //!< 对端是否发送过 SACK 块
+
+    std::unique_ptr<CongestionControl> cc_;  //!< 拥塞控制
+    DeliveryRateSampler sampler_{};          //!< 交付速率采样
+    uint64_t _time_ms{};                     //!< 累计经过的时间
+    uint64_t _retransmitted_segments{};
+
+    RackState _rack{};
+    std::optional<uint64_t> _tlp_end{};  //!< 尾部探测发出时的 next_seqno
+    uint64_t _loss_probes{};
+
+    MtuSearch _mtu{};
+    uint64_t _mtu_probes{};
+
+    /* 持续计时器 (RFC 9293 3.8.6.1)：对端窗口为零且没有在途数据时，
+       按指数退避发送窗口探测，直到窗口重新打开 */
+    std::optional<uint64_t> _persist_elapsed_ms{};
+    unsigned _persist_backoff{};
+    bool _window_probe_pending{};  //!< 下一个发出的报文是窗口探测
+    uint64_t _window_probes{};
+    uint64_t _max_window{};  //!< 对端通告过的最大窗口
+
+    bool _corked{cfg_.cork};
+    std::optional<uint64_t> _cork_wait_ms{};  //!< 不足 MSS 的数据已等待的时间
+
+    uint64_t next_seqno() const {
+        return _started + _segmented_bytes + _finished;
+    }
+
+    //! 时间戳选项使用的时钟 (ms)
+    uint32_t ts_clock() const { return static_cast<uint32_t>(_time_ms); }
+
+    //! 发送或重传一个报文，记录发送时的状态
+    TCPSenderMessage transmit(OutstandingSegment& seg);
+    //! 把已发送过的报文加入重传
+    void queue_retransmit(OutstandingSegment& seg);
+    //! 报文被对端收到 (累计确认或 SACK)
+    void on_delivered(const OutstandingSegment& seg);
+    //! 根据 SACK 块标记已被接收的报文
+    void update_scoreboard(const std::vector<TCPSackBlock>& blocks,
+                           uint64_t ackno);
+    //! 推断丢失的报文 (RFC 6675 IsLost 与 RACK)，返回是否有新的丢包
+    bool mark_losses();
+    //! RACK 判定丢包前等待乱序的时间
+    uint64_t rack_reorder_window() const;
+    //! 标记丢包，必要时进入恢复，并重传空洞
+    void repair_losses();
+    bool is_mtu_probe(const OutstandingSegment& seg) const {
+        return _mtu.probe_seqno == seg.seqno;
+    }
+    //! 下一个新报文是否作为 MTU 探测，返回探测的大小
+    std::optional<uint64_t> next_mtu_probe();
+    //! 根据探测报文是否送达调整搜索区间，返回探测是否丢失
+    bool update_mtu_search();
+    //! 把报文拆分成不超过当前 MSS 的报文
+    void split_segment(size_t index);
+    //! Nagle 与 cork：不足 MSS 的报文是否继续等待
+    bool hold_small_segment();
+    //! 尾部丢包探测的超时时间，不需要探测时为空
+    std::optional<uint64_t> probe_timeout() const;
+    //! 发送时使用的拥塞窗口
+    //! 对端不发送 SACK 时，快速恢复中每个重复 ACK 使窗口膨胀一个 MSS
+    //! (RFC 6582)
+    uint64_t send_window() const;
+    //! 在窗口允许的范围内重传丢失的报文
+    //! \param first_only 只重传第一个空洞，且不受拥塞窗口限制
+    void retransmit_holes(bool first_only = false);
 
    public:
-    void push(Reader& outbound_stream);
+    //! 把流中的数据分段；sack_blocks 为报文要携带的 SACK 块数，载荷相应减小
+    void push(Reader& outbound_stream, size_t sack_blocks = 0);
+
+    //! 报文的载荷与 SACK 选项合计不超过 MSS 时最多能携带的 SACK 块数；
+    //! SACK 块出现之前分好的报文 (包括重传) 只携带放得下的块
+    size_t sack_blocks_fit(const TCPSenderMessage& message) const;
 
     std::optional<TCPSenderMessage> maybe_send();
 
+    //! 开启或解除 cork，解除后按 Nagle 算法发送剩余的数据
+    void set_cork(bool cork);
+
     //! 发送空数据包
     TCPSenderMessage send_empty_message() const;
 
-    void receive_ack(const TCPReceiverMessage& msg);
+    //! 处理对端的确认；pure_ack 表示报文不占用序号 (不带数据和 SYN/FIN)，
+    //! 只有这样的报文才计为重复 ACK
+    void receive_ack(const TCPReceiverMessage& msg, bool pure_ack = true);
 
     void tick(uint64_t ms_since_last_tick);
 
-    uint64_t sequence_numbers_in_flight() const;
+    //! 距最近一个计时器 (cork、持续、RACK、尾部丢包探测、重传) 到期的时间，
+    //! 没有计时器时为空；在此之前 tick() 不会触发任何动作
+    std::optional<uint64_t> next_timeout_ms() const;
+
+    //! 在途报文的发送时间不可信，确认时不用它们测量 RTT
+    void forgo_rtt_samples();
+
+    uint64_t sequence_numbers_in_flight() const { return _seqnos_in_flight; }
     uint64_t consecutive_retransmissions() const;
 
+    //! 估计仍在网络中的序列号数量 (RFC 6675 pipe)
+    uint64_t pipe() const;
+    bool in_recovery() const { return _recovery_point.has_value(); }
+
+    const CongestionControl& congestion_control() const { return *cc_; }
+    uint64_t peer_window() const { return _window_size; }  //!< 对端的窗口
+    std::optional<uint64_t> srtt_ms() const { return rtt_.srtt_ms(); }
+
+    //! 发出报文的速率 (bytes/s)，0 表示不限速
+    uint64_t pacing_rate() const;
+    //! 按速率发出时允许的突发 (bytes)
+    uint64_t pacing_burst() const;
+
+    TCPStats stats() const;
+
     /* 接收端 */
    private:
     std::optional<Wrap32> receive_isn_{};
+    bool _peer_sack_permitted{};  //!< 对端是否允许 SACK
+
+    /* 窗口扩大 (RFC 7323)，双方的 SYN 都带有该选项时生效 */
+    uint8_t _rcv_window_shift{};  //!< 本端通告窗口时使用的因子
+    bool _sent_window_scale{};    //!< 本端的 SYN 是否带有该选项
+    std::optional<uint8_t> _peer_window_shift{};  //!< 对端 SYN 中的因子
+
+    bool window_scaling() const {
+        return _sent_window_scale && _peer_window_shift.has_value();
+    }
+
+    /* 时间戳 (RFC 7323)，对端的 SYN 带有该选项且本端启用时生效 */
+    bool _peer_timestamps{};  //!< 对端的 SYN 是否带有该选项
+    uint32_t _ts_recent{};    //!< 下一个 ACK 要回显的 TSval
+
+    bool timestamping() const { return cfg_.timestamps && _peer_timestamps; }
 
    public:
     //! 接收数据包
@@ -57,9 +229,21 @@ class Transceiver {
                      Reassembler& reassembler,
                      Writer& inbound_stream);
 
-    //! 填写数据包中的ACK和窗口大小
-    TCPReceiverMessage send_ack(const Writer& inbound_stream) const;
+    //! 首部预测 (Van Jacobson)：按序到达、不带标志的纯数据报文，
+    //! 或推进 snd.una 的纯 ACK，只需几次比较即可处理；
+    //! 返回 false 时没有任何改动，由调用方走完整路径
+    bool receive_predicted(const TCPSenderMessage& message,
+                           const TCPReceiverMessage& msg,
+                           Reassembler& reassembler,
+                           Writer& inbound_stream);
+
+    //! PAWS：时间戳早于已记录的值，是序列号回绕之前的旧报文 (RFC 7323 5)
+    bool paws_reject(const TCPSenderMessage& message) const;
+
+    //! 填写数据包中的ACK、窗口大小和SACK块
+    TCPReceiverMessage send_ack(const Reassembler& reassembler,
+                                const Writer& inbound_stream) const;
 
    public:
-    Transceiver(uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn);
+    explicit Transceiver(const TCPConfig& cfg);
 };
@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "buffer/string_buffer.h"
@@ -66,6 +67,9 @@ class FileDescriptor {
   // 读入 `buffer`
   void read(std::string& buffer);
   void read(std::vector<std::string>& buffers);
+  // 读入调用方提供的内存，不分配也不改变其大小
+  // 返回读到的字节数 (非阻塞且暂无数据时为 0)
+  size_t read(std::span<char> buffer);
 
   // 尝试写入缓冲区
   // 返回写入的字节数
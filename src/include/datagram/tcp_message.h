@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "buffer/string_buffer.h"
 #include "utils/parser.h"
@@ -15,17 +16,35 @@ struct TCPSenderMessage {
   bool SYN{false};
   Buffer payload{};
   bool FIN{false};
+  std::optional<uint16_t> mss{};  //!< SYN 中携带的 MSS 选项
+  bool sack_permitted{false};  //!< SYN 中携带的 SACK-Permitted 选项
+  std::optional<uint8_t> window_scale{};  //!< SYN 中携带的窗口扩大因子
+  std::optional<uint32_t> ts_val{};  //!< 时间戳选项中的 TSval (RFC 7323)
 
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }
 };
 
+/**
+ * @brief SACK 选项中的一个块，表示已收到的 [left, right) 区间
+ */
+struct TCPSackBlock {
+  Wrap32 left{0};
+  Wrap32 right{0};
+};
+
 /**
  * @brief TCP报头中关于接收的内容
  */
 struct TCPReceiverMessage {
   std::optional<Wrap32> ackno{};
-  uint16_t window_size{};
+  //! 接收窗口，序列化时右移 window_shift 位写入报头 (RFC 7323)；
+  //! 解析得到的是报头中的原始值，window_shift 为 0，由收发器按协商的因子扩大
+  uint32_t window_size{};
+  uint8_t window_shift{};
+  std::vector<TCPSackBlock> sack_blocks{};  //!< SACK 选项 (RFC 2018)
+  //! 时间戳选项中回显的 TSecr，只随 ts_val 一起发送，且只在 ACK 中有效
+  std::optional<uint32_t> ts_ecr{};
 };
 
 /**
@@ -46,9 +65,15 @@ struct TCPSegment {
   bool reset{};  //!< 连接遇到异常错误，应关闭
   UserDatagramInfo udinfo{};
 
-  void parse(Parser& parser, uint32_t datagram_layer_pseudo_checksum);
+  //! \param[in] datagram_layer_pseudo_checksum 为空时不验证校验和
+  //! (tun 的 virtio-net 头表明内核已验证或尚未填写)
+  void parse(Parser& parser,
+             std::optional<uint32_t> datagram_layer_pseudo_checksum);
   void serialize(Serializer& serializer) const;
 
+  //! TCP 报头长度 (bytes)，包括选项
+  size_t header_length() const;
+
   void compute_checksum(uint32_t datagram_layer_pseudo_checksum);
 };
 
@@ -2,6 +2,8 @@
 #include <sys/epoll.h>
 #include <unistd.h>
 
+#include <array>
+#include <memory>
 #include <unordered_map>
 
 #include "polling/rule.h"
@@ -19,6 +21,12 @@ class B_epoll {
      * int16_t: Direction
      */
     std::unordered_map<int, int16_t> added_fds;
+
+    /**
+     * 就绪的 fd 对应的规则，按 fd 直接查找
+     * 下标 0 为读规则，1 为写规则；规则被移除后 weak_ptr 失效
+     */
+    std::unordered_map<int, std::array<std::weak_ptr<FDRule>, 2>> rules;
     int num_events;
     epoll_event* events;
 
@@ -30,7 +38,7 @@ class B_epoll {
 
     int b_epoll_wait(const int timeout_ms);
 
-    void call(std::list<std::shared_ptr<FDRule>>& _fd_rules);
+    void call();
 
     void clear(int fd, int16_t dir);
     void clear_all();
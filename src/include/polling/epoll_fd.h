@@ -0,0 +1,29 @@
+#pragma once
+
+#include <sys/epoll.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "datagram/file_descriptor.h"
+
+/**
+ * @brief 一组文件描述符的 epoll 实例，自身可读时表示其中有就绪的描述符；
+ * 用于在事件循环的一条规则中服务大量描述符，每次只处理就绪的那些
+ */
+class EpollFD : public FileDescriptor {
+ public:
+  EpollFD();
+
+  //! 加入描述符，就绪时返回 data 作为标识
+  void add(const FileDescriptor& fd, uint32_t events, void* data);
+
+  //! 修改已加入的描述符关注的事件
+  void modify(const FileDescriptor& fd, uint32_t events, void* data);
+
+  //! 移除描述符
+  void remove(const FileDescriptor& fd);
+
+  //! 不阻塞地取出至多 max_events 个就绪事件
+  std::vector<epoll_event> wait(size_t max_events);
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "datagram/file_descriptor.h"
+
+/**
+ * @brief 线程间的通知 (eventfd)：notify() 后可读，drain() 清除
+ */
+class EventFD : public FileDescriptor {
+ public:
+  EventFD();
+
+  //! 唤醒等待该文件描述符的线程，可以在任意线程调用
+  void notify();
+
+  //! 读出累计的通知次数，清除可读状态
+  void drain();
+};
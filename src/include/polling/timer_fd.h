@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "datagram/file_descriptor.h"
+
+/**
+ * @brief 单次触发的定时器 (timerfd)，到期后可读，精度不受轮询超时限制
+ */
+class TimerFD : public FileDescriptor {
+  bool armed_{};
+
+ public:
+  TimerFD();
+
+  //! 在 delay_us 之后触发，覆盖尚未到期的设置
+  void arm(uint64_t delay_us);
+
+  //! 读出到期次数，清除可读状态
+  void drain();
+
+  bool armed() const { return armed_; }
+};
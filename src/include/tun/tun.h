@@ -5,11 +5,32 @@
 #include "datagram/file_descriptor.h"
 
 class TunTapFD : public FileDescriptor {
+  bool _offload{};  //!< 每个数据包前有 virtio-net 头，启用了校验和与 TSO 卸载
+
  public:
-  explicit TunTapFD(const std::string& devname, bool is_tun);
+  //! \param[in] multi_queue 以 IFF_MULTI_QUEUE 打开，每次打开得到设备的
+  //! 一个新队列；设备创建时的模式必须与之相同
+  //! \param[in] offload 以 IFF_VNET_HDR 打开并启用校验和与 TSO 卸载
+  //! (TUNSETOFFLOAD)：读写的数据包前有 virtio-net 头，可以是内核合并或
+  //! 待内核切分的超过 MTU 的 TCP 报文，校验和可以只填伪首部
+  explicit TunTapFD(const std::string& devname, bool is_tun,
+                    bool multi_queue = false, bool offload = false);
+
+  bool offload() const { return _offload; }
+
+  //! 设备是否以多队列模式创建 (读取 sysfs 中的 tun_flags)
+  static bool is_multi_queue(const std::string& devname);
+
+  //! 把本队列挂回设备 (TUNSETQUEUE)，内核重新向它分发数据包
+  void attach_queue();
+
+  //! 把本队列从设备摘下，内核不再向它分发，它也不能再读写
+  void detach_queue();
 };
 
 class TunFD : public TunTapFD {
  public:
-  explicit TunFD(const std::string& devname) : TunTapFD(devname, true) {}
+  explicit TunFD(const std::string& devname, bool multi_queue = false,
+                 bool offload = false)
+      : TunTapFD(devname, true, multi_queue, offload) {}
 };
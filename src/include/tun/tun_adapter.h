@@ -2,8 +2,10 @@
 
 #include <optional>
 #include <random>
+#include <span>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "config/tcp_config.h"
 #include "datagram/file_descriptor.h"
@@ -11,6 +13,56 @@
 #include "tun/tun.h"
 #include "utils/random.h"
 
+/**
+ * @brief 一条 TCP 连接的四元组 (本端视角)，多条连接共用一个 tun 设备时
+ * 按它把报文分给各自的连接
+ */
+struct FourTuple {
+  uint32_t local_address{};
+  uint16_t local_port{};
+  uint32_t remote_address{};
+  uint16_t remote_port{};
+
+  //! source 为本端，destination 为对端
+  static FourTuple of(const FdAdapterConfig& cfg);
+
+  //! 还原为 source 为本端、destination 为对端的地址
+  FdAdapterConfig addresses() const;
+
+  bool operator==(const FourTuple& other) const = default;
+};
+
+struct FourTupleHash {
+  size_t operator()(const FourTuple& tuple) const;
+};
+
+/**
+ * @brief virtio-net 头，即 <linux/virtio_net.h> 中的 virtio_net_hdr
+ * (该头文件不能在 C++ 中包含)；tun 上的字段为主机字节序
+ */
+struct VirtioNetHeader {
+  uint8_t flags;
+  uint8_t gso_type;
+  uint16_t hdr_len;      //!< GSO 报文每段复制的报头长度
+  uint16_t gso_size;     //!< GSO 报文每段的载荷长度
+  uint16_t csum_start;   //!< 从此处起计算校验和
+  uint16_t csum_offset;  //!< 校验和字段相对 csum_start 的偏移
+
+  static constexpr uint8_t F_NEEDS_CSUM = 1;  //!< 校验和只填了伪首部
+  static constexpr uint8_t F_DATA_VALID = 2;  //!< 内核已验证校验和
+  static constexpr uint8_t GSO_NONE = 0;
+  static constexpr uint8_t GSO_TCPV4 = 1;
+};
+static_assert(sizeof(VirtioNetHeader) == 10);
+
+//! segs 中从 begin 开始、能合并为一个 TSO 超级报文的报文的结尾：内核切分
+//! 时每段复制第一个报文的报头，按它的载荷长度切分，只有最后一段可以更短
+size_t coalesce_run(const std::vector<TCPSegment>& segs, size_t begin);
+
+//! 写入 run 时使用的 virtio-net 头：TCP 校验和由内核补全；run 中有多个
+//! 报文时，它们作为超级报文按第一个报文的载荷长度切分
+VirtioNetHeader offload_header(std::span<const TCPSegment> run);
+
 //! \brief 实现传输层和网络层的报文转换
 class TCPOverIPv4OverTunFdAdapter {
  private:
@@ -21,34 +73,86 @@ class TCPOverIPv4OverTunFdAdapter {
 
   std::default_random_engine _rand{get_random_engine()};
 
+  //! 读取数据包的缓冲区，每次读取重复使用，只从其中的视图解析；
+  //! 交出的载荷另行复制为大小合适的字符串
+  Buffer _rx_buffer{};
+
+  //! 从 tun 读到的 IPv4 数据报
+  struct InboundDatagram {
+    IPv4Datagram dgram;
+    bool checksum_trusted{};  //!< virtio-net 头表明无需验证 TCP 校验和
+  };
+
+  //! 读取一个 IPv4 数据报，按下行丢包率丢弃
+  std::optional<InboundDatagram> read_datagram();
+
+  //! 在 virtio-net 头之后写入 run 中的报文，TCP 校验和只填伪首部，
+  //! 由内核补全；多个报文时只写第一个报文的报头，之后各报文的载荷
+  //! 不经复制依次接在它之后，由内核切分
+  void write_offloaded(std::span<TCPSegment> run,
+                       const FdAdapterConfig& addresses);
+
  public:
   explicit TCPOverIPv4OverTunFdAdapter(TunFD&& tun) : _tun(std::move(tun)) {}
 
   //! 尝试读取并解析包含与当前连接相关的 TCP 数据报的 IPv4 数据报
   std::optional<TCPSegment> read();
 
+  //! 读取任意连接的 TCP 数据报，连同它所属连接的四元组一起返回
+  std::optional<std::pair<FourTuple, TCPSegment>> read_flow();
+
   //! 从 TCP 数据报创建 IPv4 数据报并将其写入 Tun 设备
-  void write(TCPSegment& seg) {
+  void write(TCPSegment& seg) { write(seg, _cfg); }
+
+  //! 按给定连接的地址写入，供多条连接共用一个适配器
+  void write(TCPSegment& seg, const FdAdapterConfig& addresses) {
     if (_should_drop(true)) {
       return;
     }
-    _tun.write(serialize(wrap_tcp_in_ip(seg)));
+    if (_tun.offload()) {
+      write_offloaded({&seg, 1}, addresses);
+      return;
+    }
+    _tun.write(serialize(wrap_tcp_in_ip(seg, addresses)));
   }
 
+  //! 写入同一连接依次发出的一组报文；tun 启用了卸载时，序号连续、
+  //! 报头相同的报文合并为 TSO 超级报文，一次写入，由内核切分
+  void write(std::vector<TCPSegment>& segs, const FdAdapterConfig& addresses);
+
   explicit operator TunFD&() { return _tun; }
 
   explicit operator const TunFD&() const { return _tun; }
 
   FileDescriptor& fd() { return _tun; }
 
-  std::optional<TCPSegment> unwrap_tcp_in_ip(const IPv4Datagram& ip_dgram);
+  //! 多队列的 tun 上挂回或摘下本适配器的队列
+  void attach_queue() { _tun.attach_queue(); }
+  void detach_queue() { _tun.detach_queue(); }
+
+  //! \param[in] verify_checksum 为 false 时不验证 TCP 校验和
+  std::optional<TCPSegment> unwrap_tcp_in_ip(const IPv4Datagram& ip_dgram,
+                                             bool verify_checksum = true);
 
-  IPv4Datagram wrap_tcp_in_ip(TCPSegment& seg);
+  IPv4Datagram wrap_tcp_in_ip(TCPSegment& seg) {
+    return wrap_tcp_in_ip(seg, _cfg);
+  }
+
+  //! \param[in] partial_checksum 为 true 时 TCP 校验和只填伪首部的和
+  //! \param[in] trailing_payload 在数据报之后另行写入的载荷长度，
+  //! 计入 IP 总长度和伪首部
+  IPv4Datagram wrap_tcp_in_ip(TCPSegment& seg,
+                              const FdAdapterConfig& addresses,
+                              bool partial_checksum = false,
+                              size_t trailing_payload = 0);
 
   FdAdapterConfig& config_mutable() { return _cfg; }
 
   void set_listening(const bool l) { _listen = l; }
 
+  //! 结束监听，此后只接收这条连接的报文
+  void accept_flow(const FourTuple& tuple);
+
   bool listening() const { return _listen; }
 
   void tick(const size_t) {}
@@ -63,11 +63,8 @@ class Parser {
       if (empty()) {
         return;
       }
-      std::string first_str = std::move(buffer_.front());
-      if (skip_) {
-        first_str = first_str.substr(skip_);
-      }
-      out.emplace_back(std::move(first_str));
+      // 交出切片，与输入共享内存，不复制也不改动输入
+      out.emplace_back(buffer_.front().substr(skip_));
       buffer_.pop_front();
       for (auto&& x : buffer_) {
         out.emplace_back(std::move(x));
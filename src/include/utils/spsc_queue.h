@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 单生产者、单消费者的无锁环形队列，容量固定
+ * 生产者只写 _tail，消费者只写 _head，两者分处不同的缓存行
+ */
+template <typename T>
+class SpscQueue {
+  static constexpr size_t CACHE_LINE = 64;
+
+  std::vector<std::optional<T>> _slots;
+  alignas(CACHE_LINE) std::atomic<size_t> _head{};  //!< 下一个取出的位置
+  alignas(CACHE_LINE) std::atomic<size_t> _tail{};  //!< 下一个放入的位置
+
+ public:
+  explicit SpscQueue(const size_t capacity) : _slots(capacity) {}
+
+  //! 生产者调用；队列已满时返回 false，元素不被移走
+  bool push(T&& value) {
+    const size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) == _slots.size()) {
+      return false;
+    }
+    _slots[tail % _slots.size()] = std::move(value);
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  //! 消费者调用；队列为空时返回空
+  std::optional<T> pop() {
+    const size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire)) {
+      return {};
+    }
+    std::optional<T> value = std::move(_slots[head % _slots.size()]);
+    _slots[head % _slots.size()].reset();
+    _head.store(head + 1, std::memory_order_release);
+    return value;
+  }
+};
@@ -28,6 +28,10 @@ void B_epoll::insert_rule(std::shared_ptr<FDRule> rule_addr) {
     // 没找到，加入
     added_fds.insert({rule.fd.fd_num(), static_cast<int16_t>(rule.direction)});
   }
+  auto& slot = rules[rule.fd.fd_num()][rule.direction == Direction::Out];
+  if (slot.expired()) {
+    slot = rule_addr;
+  }
 }
 
 void B_epoll::insert_to_epoll() {
@@ -54,33 +58,24 @@ int B_epoll::b_epoll_wait(const int timeout_ms) {
   return 1;
 }
 
-void B_epoll::call(std::list<std::shared_ptr<FDRule>>& _fd_rules) {
+void B_epoll::call() {
   for (int i = 0; i < num_events; ++i) {
-    auto fd_num = events[i].data.fd;
+    const auto it = rules.find(events[i].data.fd);
+    if (it == rules.end()) {
+      continue;
+    }
 
     // 优先写事件
     if (events[i].events & EPOLLOUT) {
-      for (auto it = _fd_rules.begin(); it != _fd_rules.end();) {
-        auto& this_rule = **it;
-        if (this_rule.fd.fd_num() == fd_num &&
-            this_rule.direction == Direction::Out) {
-          this_rule.callback();
-          break;
-        }
-        ++it;
+      if (auto rule = it->second[1].lock()) {
+        rule->callback();
       }
     }
 
     // 再读事件
     if (events[i].events & EPOLLIN) {
-      for (auto it = _fd_rules.begin(); it != _fd_rules.end();) {
-        auto& this_rule = **it;
-        if (this_rule.fd.fd_num() == fd_num &&
-            this_rule.direction == Direction::In) {
-          this_rule.callback();
-          break;
-        }
-        ++it;
+      if (auto rule = it->second[0].lock()) {
+        rule->callback();
       }
     }
   }
@@ -101,6 +96,7 @@ void B_epoll::clear(int fd, int16_t dir) {
     throw std::runtime_error("clear删除失败");
   }
   added_fds.erase(fd);
+  rules.erase(fd);
 }
 
 void B_epoll::clear_all() {
@@ -120,6 +116,7 @@ void B_epoll::clear_all() {
     }
   }
   added_fds.clear();
+  rules.clear();
   num_events = 0;
   free(events);
   events = nullptr;
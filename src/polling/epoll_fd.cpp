@@ -0,0 +1,38 @@
+#include "polling/epoll_fd.h"
+
+#include "utils/exception.h"
+
+using namespace std;
+
+EpollFD::EpollFD()
+    : FileDescriptor(
+          ::CheckSystemCall("epoll_create1", epoll_create1(EPOLL_CLOEXEC))) {}
+
+void EpollFD::add(const FileDescriptor& fd, uint32_t events, void* data) {
+  epoll_event ev{events, {.ptr = data}};
+  CheckSystemCall("epoll_ctl add",
+                  epoll_ctl(fd_num(), EPOLL_CTL_ADD, fd.fd_num(), &ev));
+}
+
+void EpollFD::modify(const FileDescriptor& fd, uint32_t events, void* data) {
+  epoll_event ev{events, {.ptr = data}};
+  CheckSystemCall("epoll_ctl mod",
+                  epoll_ctl(fd_num(), EPOLL_CTL_MOD, fd.fd_num(), &ev));
+}
+
+void EpollFD::remove(const FileDescriptor& fd) {
+  CheckSystemCall("epoll_ctl del",
+                  epoll_ctl(fd_num(), EPOLL_CTL_DEL, fd.fd_num(), nullptr));
+}
+
+vector<epoll_event> EpollFD::wait(const size_t max_events) {
+  vector<epoll_event> events(max_events);
+  const int n = CheckSystemCall(
+      "epoll_wait",
+      epoll_wait(fd_num(), events.data(), static_cast<int>(max_events), 0));
+  events.resize(n);
+  // poll 报告可读后，就绪的描述符可能已不再满足条件而返回 0 个事件，
+  // 同样计为一次读取，事件循环不会误判为忙等
+  register_read();
+  return events;
+}
@@ -0,0 +1,30 @@
+#include "polling/event_fd.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+
+#include "utils/exception.h"
+
+using namespace std;
+
+EventFD::EventFD()
+    : FileDescriptor(::CheckSystemCall(
+          "eventfd", eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {
+  set_blocking(false);
+}
+
+void EventFD::notify() {
+  // 不经过 write()，它的写入计数不是线程安全的
+  const uint64_t one = 1;
+  ::CheckSystemCall("eventfd write", static_cast<int>(::write(
+                                        fd_num(), &one, sizeof(one))));
+}
+
+void EventFD::drain() {
+  // 只在等待的线程调用；没有通知时返回 EAGAIN，同样视为已清除
+  string count(sizeof(uint64_t), 0);
+  read(count);
+}
@@ -0,0 +1,36 @@
+#include "polling/timer_fd.h"
+
+#include <sys/timerfd.h>
+
+#include <algorithm>
+#include <string>
+
+#include "utils/exception.h"
+
+using namespace std;
+
+static constexpr uint64_t NS_PER_US = 1000;
+static constexpr uint64_t US_PER_SEC = 1000000;
+
+TimerFD::TimerFD()
+    : FileDescriptor(::CheckSystemCall(
+          "timerfd_create",
+          timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))) {}
+
+void TimerFD::arm(uint64_t delay_us) {
+  // 全零的 it_value 表示解除定时器，至少等待 1 us
+  delay_us = max(delay_us, uint64_t{1});
+  itimerspec spec{};
+  spec.it_value.tv_sec = static_cast<time_t>(delay_us / US_PER_SEC);
+  spec.it_value.tv_nsec =
+      static_cast<long>(delay_us % US_PER_SEC * NS_PER_US);
+  CheckSystemCall("timerfd_settime", timerfd_settime(fd_num(), 0, &spec,
+                                                     nullptr));
+  armed_ = true;
+}
+
+void TimerFD::drain() {
+  string expirations(sizeof(uint64_t), 0);
+  read(expirations);
+  armed_ = false;
+}
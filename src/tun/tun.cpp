@@ -6,6 +6,7 @@
 #include <sys/ioctl.h>
 
 #include <cstring>
+#include <fstream>
 
 #include "utils/exception.h"
 
@@ -13,13 +14,16 @@ static constexpr const char* CLONEDEV = "/dev/net/tun";
 
 using namespace std;
 
-TunTapFD::TunTapFD(const string& devname, const bool is_tun)
+TunTapFD::TunTapFD(const string& devname, const bool is_tun,
+                   const bool multi_queue, const bool offload)
     : FileDescriptor(
-          ::CheckSystemCall("open", open(CLONEDEV, O_RDWR | O_CLOEXEC))) {
+          ::CheckSystemCall("open", open(CLONEDEV, O_RDWR | O_CLOEXEC))),
+      _offload(offload) {
   struct ifreq tun_req {};
 
-  tun_req.ifr_flags = static_cast<int16_t>((is_tun ? IFF_TUN : IFF_TAP) |
-                                           IFF_NO_PI);  // no packetinfo
+  tun_req.ifr_flags = static_cast<int16_t>(
+      (is_tun ? IFF_TUN : IFF_TAP) | IFF_NO_PI |  // no packetinfo
+      (multi_queue ? IFF_MULTI_QUEUE : 0) | (offload ? IFF_VNET_HDR : 0));
 
   // copy devname to ifr_name, making sure to null terminate
 
@@ -28,4 +32,27 @@ TunTapFD::TunTapFD(const string& devname, const bool is_tun)
 
   CheckSystemCall("ioctl",
                   ioctl(fd_num(), TUNSETIFF, static_cast<void*>(&tun_req)));
+
+  // 内核发来的报文可以只有伪首部校验和，也可以是 TSO 的超级报文；
+  // 卸载的设置随设备保留，不启用时也要清除，以免沿用上次打开时的设置
+  const unsigned long features = offload ? TUN_F_CSUM | TUN_F_TSO4 : 0;
+  CheckSystemCall("ioctl", ioctl(fd_num(), TUNSETOFFLOAD, features));
+}
+
+bool TunTapFD::is_multi_queue(const string& devname) {
+  ifstream flags("/sys/class/net/" + devname + "/tun_flags");
+  unsigned value = 0;
+  // 设备不存在时打开会新建一个单队列的设备
+  return (flags >> hex >> value) and (value & IFF_MULTI_QUEUE) != 0;
 }
+
+static void set_queue(const int fd, const int16_t flag) {
+  struct ifreq tun_req {};
+  tun_req.ifr_flags = flag;
+  CheckSystemCall("ioctl",
+                  ioctl(fd, TUNSETQUEUE, static_cast<void*>(&tun_req)));
+}
+
+void TunTapFD::attach_queue() { set_queue(fd_num(), IFF_ATTACH_QUEUE); }
+
+void TunTapFD::detach_queue() { set_queue(fd_num(), IFF_DETACH_QUEUE); }
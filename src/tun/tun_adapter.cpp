@@ -1,13 +1,22 @@
 #include "tun/tun_adapter.h"
 
-#include <arpa/inet.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 
+#include "datagram/checksum.h"
 #include "utils/parser.h"
 
 using namespace std;
 
+//! 内核合并或待内核切分的报文的上限：IPv4 数据报的最大长度
+static constexpr size_t MAX_OFFLOAD_LENGTH = UINT16_MAX;
+
+//! TCP 报头中校验和字段的偏移
+static constexpr uint16_t TCP_CHECKSUM_OFFSET = 16;
+
 optional<TCPSegment> TCPOverIPv4OverTunFdAdapter::unwrap_tcp_in_ip(
-    const IPv4Datagram& ip_dgram) {
+    const IPv4Datagram& ip_dgram, const bool verify_checksum) {
   // is the IPv4 datagram for us?
   // Note: it's valid to bind to address "0" (INADDR_ANY) and reply from actual
   // address contacted
@@ -29,7 +38,9 @@ optional<TCPSegment> TCPOverIPv4OverTunFdAdapter::unwrap_tcp_in_ip(
 
   // is the payload a valid TCP segment?
   TCPSegment tcp_seg;
-  if (not parse(tcp_seg, ip_dgram.payload, ip_dgram.header.pseudo_checksum())) {
+  if (not parse(tcp_seg, ip_dgram.payload,
+                 verify_checksum ? optional{ip_dgram.header.pseudo_checksum()}
+                                 : nullopt)) {
     return {};
   }
 
@@ -42,11 +53,10 @@ optional<TCPSegment> TCPOverIPv4OverTunFdAdapter::unwrap_tcp_in_ip(
   // source) in reply?
   if (listening()) {
     if (tcp_seg.sender_message.SYN and not tcp_seg.reset) {
-      config_mutable().source = Address{
-          inet_ntoa({htobe32(ip_dgram.header.dst)}), config().source.port()};
-      config_mutable().destination = Address{
-          inet_ntoa({htobe32(ip_dgram.header.src)}), tcp_seg.udinfo.src_port};
-      set_listening(false);
+      accept_flow({.local_address = ip_dgram.header.dst,
+                   .local_port = config().source.port(),
+                   .remote_address = ip_dgram.header.src,
+                   .remote_port = tcp_seg.udinfo.src_port});
     } else {
       return {};
     }
@@ -60,38 +70,239 @@ optional<TCPSegment> TCPOverIPv4OverTunFdAdapter::unwrap_tcp_in_ip(
   return tcp_seg;
 }
 
-IPv4Datagram TCPOverIPv4OverTunFdAdapter::wrap_tcp_in_ip(TCPSegment& seg) {
+void TCPOverIPv4OverTunFdAdapter::accept_flow(const FourTuple& tuple) {
+  const FdAdapterConfig addresses = tuple.addresses();
+  _cfg.source = addresses.source;
+  _cfg.destination = addresses.destination;
+  set_listening(false);
+}
+
+IPv4Datagram TCPOverIPv4OverTunFdAdapter::wrap_tcp_in_ip(
+    TCPSegment& seg, const FdAdapterConfig& addresses,
+    const bool partial_checksum, const size_t trailing_payload) {
   // set the port numbers in the TCP segment
-  seg.udinfo.src_port = config().source.port();
-  seg.udinfo.dst_port = config().destination.port();
+  seg.udinfo.src_port = addresses.source.port();
+  seg.udinfo.dst_port = addresses.destination.port();
 
   // create an Internet Datagram and set its addresses and length
   IPv4Datagram ip_dgram;
-  ip_dgram.header.src = config().source.ipv4_numeric();
-  ip_dgram.header.dst = config().destination.ipv4_numeric();
-  ip_dgram.header.len = ip_dgram.header.hlen * 4 + 20 /* tcp header len */ +
-                        seg.sender_message.payload.size();
+  ip_dgram.header.src = addresses.source.ipv4_numeric();
+  ip_dgram.header.dst = addresses.destination.ipv4_numeric();
+  ip_dgram.header.len = ip_dgram.header.hlen * 4 + seg.header_length() +
+                        seg.sender_message.payload.size() + trailing_payload;
 
   // set payload, calculating TCP checksum using information from IP header
-  seg.compute_checksum(ip_dgram.header.pseudo_checksum());
+  if (partial_checksum) {
+    // 只填伪首部之和 (不取反)，与 CHECKSUM_PARTIAL 的约定相同
+    seg.udinfo.cksum = static_cast<uint16_t>(
+        ~InternetChecksum{ip_dgram.header.pseudo_checksum()}.value());
+  } else {
+    seg.compute_checksum(ip_dgram.header.pseudo_checksum());
+  }
   ip_dgram.header.compute_checksum();
   ip_dgram.payload = serialize(seg);
 
   return ip_dgram;
 }
 
+optional<TCPOverIPv4OverTunFdAdapter::InboundDatagram>
+TCPOverIPv4OverTunFdAdapter::read_datagram() {
+  // 启用卸载时数据包前有 virtio-net 头，内核合并的报文可达 64 KiB
+  const bool offload = _tun.offload();
+  const size_t vnet_length = offload ? sizeof(VirtioNetHeader) : 0;
+  string& raw = _rx_buffer;  // 整个字符串而非切片，不会复制
+  if (raw.size() < vnet_length + MAX_OFFLOAD_LENGTH) {
+    raw.resize(vnet_length + MAX_OFFLOAD_LENGTH);
+  }
+  const size_t length = _tun.read(span{raw});
+  if (length < vnet_length + IPv4Header::LENGTH) {
+    return {};
+  }
+
+  InboundDatagram inbound;
+  if (offload) {
+    VirtioNetHeader vnet{};
+    memcpy(&vnet, raw.data(), sizeof(vnet));
+    // 校验和尚未填写 (NEEDS_CSUM) 或已由内核验证 (DATA_VALID)，
+    // GSO 报文整个交给 TCP，不再切分
+    inbound.checksum_trusted =
+        (vnet.flags & (VirtioNetHeader::F_NEEDS_CSUM |
+                       VirtioNetHeader::F_DATA_VALID)) != 0;
+  }
+
+  if (not parse(inbound.dgram,
+                {_rx_buffer.substr(vnet_length, length - vnet_length)}) or
+      _should_drop(false)) {
+    return {};
+  }
+
+  // 载荷会被切片保留在接收缓冲区中：复制为大小合适的字符串，
+  // 读取用的缓冲区留给下一次读取
+  string payload;
+  payload.reserve(inbound.dgram.header.payload_length());
+  for (const auto& x : inbound.dgram.payload) {
+    payload.append(string_view{x});
+  }
+  inbound.dgram.payload = {Buffer{std::move(payload)}};
+  return inbound;
+}
+
 optional<TCPSegment> TCPOverIPv4OverTunFdAdapter::read() {
-  vector<string> strs(2);
-  strs.front().resize(IPv4Header::LENGTH);
-  _tun.read(strs);
+  if (auto inbound = read_datagram()) {
+    return unwrap_tcp_in_ip(inbound->dgram, not inbound->checksum_trusted);
+  }
+  return {};
+}
 
-  IPv4Datagram ip_dgram;
-  const vector<Buffer> buffers = {strs.at(0), strs.at(1)};
-  if (parse(ip_dgram, buffers)) {
-    if (_should_drop(false)) {
-      return {};
+optional<pair<FourTuple, TCPSegment>> TCPOverIPv4OverTunFdAdapter::read_flow() {
+  auto inbound = read_datagram();
+  if (not inbound or inbound->dgram.header.proto != IPv4Header::PROTO_TCP) {
+    return {};
+  }
+  const IPv4Datagram* ip_dgram = &inbound->dgram;
+
+  TCPSegment tcp_seg;
+  if (not parse(tcp_seg, ip_dgram->payload,
+                inbound->checksum_trusted
+                    ? nullopt
+                    : optional{ip_dgram->header.pseudo_checksum()})) {
+    return {};
+  }
+
+  // 数据报的目的地址是本端
+  const FourTuple tuple{.local_address = ip_dgram->header.dst,
+                        .local_port = tcp_seg.udinfo.dst_port,
+                        .remote_address = ip_dgram->header.src,
+                        .remote_port = tcp_seg.udinfo.src_port};
+  return make_pair(tuple, std::move(tcp_seg));
+}
+
+//! next 能否接在 [first, last] 之后合并为一个超级报文
+static bool can_coalesce(const TCPSegment& first, const TCPSegment& last,
+                         const TCPSegment& next, const size_t length) {
+  const TCPSenderMessage& head = first.sender_message;
+  const TCPSenderMessage& tail = last.sender_message;
+  const TCPSenderMessage& msg = next.sender_message;
+  if (head.SYN or first.reset or next.reset or msg.SYN or tail.FIN or
+      tail.payload.size() != head.payload.size() or msg.payload.empty() or
+      msg.payload.size() > head.payload.size() or
+      msg.seqno != tail.seqno + tail.sequence_length() or
+      msg.ts_val != head.ts_val) {
+    return false;
+  }
+  if (length + msg.payload.size() + IPv4Header::LENGTH +
+          first.header_length() >
+      MAX_OFFLOAD_LENGTH) {
+    return false;
+  }
+
+  const TCPReceiverMessage& a = first.receiver_message;
+  const TCPReceiverMessage& b = next.receiver_message;
+  return a.ackno == b.ackno and a.window_size == b.window_size and
+         a.window_shift == b.window_shift and a.ts_ecr == b.ts_ecr and
+         ranges::equal(a.sack_blocks, b.sack_blocks,
+                       [](const TCPSackBlock& x, const TCPSackBlock& y) {
+                         return x.left == y.left and x.right == y.right;
+                       });
+}
+
+size_t coalesce_run(const vector<TCPSegment>& segs, const size_t begin) {
+  size_t length = segs.at(begin).sender_message.payload.size();
+  size_t end = begin + 1;
+  while (end < segs.size() and
+         can_coalesce(segs[begin], segs[end - 1], segs[end], length)) {
+    length += segs[end].sender_message.payload.size();
+    end++;
+  }
+  return end;
+}
+
+VirtioNetHeader offload_header(const span<const TCPSegment> run) {
+  const TCPSegment& first = run.front();
+  VirtioNetHeader vnet{};
+  vnet.flags = VirtioNetHeader::F_NEEDS_CSUM;
+  vnet.csum_start = IPv4Header::LENGTH;
+  vnet.csum_offset = TCP_CHECKSUM_OFFSET;
+  if (run.size() > 1) {
+    vnet.gso_type = VirtioNetHeader::GSO_TCPV4;
+    vnet.gso_size =
+        static_cast<uint16_t>(first.sender_message.payload.size());
+    vnet.hdr_len =
+        static_cast<uint16_t>(IPv4Header::LENGTH + first.header_length());
+  }
+  return vnet;
+}
+
+void TCPOverIPv4OverTunFdAdapter::write_offloaded(
+    const span<TCPSegment> run, const FdAdapterConfig& addresses) {
+  const VirtioNetHeader vnet = offload_header(run);
+  TCPSegment& first = run.front();
+  const auto rest = run.subspan(1);
+
+  // 超级报文的报头取自第一个报文，FIN 取自最后一个
+  size_t trailing = 0;
+  for (const auto& seg : rest) {
+    trailing += seg.sender_message.payload.size();
+  }
+  if (not rest.empty()) {
+    first.sender_message.FIN = rest.back().sender_message.FIN;
+  }
+
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  vector<Buffer> buffers{string(reinterpret_cast<const char*>(&vnet),
+                                sizeof(vnet))};
+  const auto datagram =
+      serialize(wrap_tcp_in_ip(first, addresses, true, trailing));
+  buffers.insert(buffers.end(), datagram.begin(), datagram.end());
+  for (const auto& seg : rest) {
+    buffers.push_back(seg.sender_message.payload);
+  }
+  _tun.write(buffers);
+}
+
+void TCPOverIPv4OverTunFdAdapter::write(vector<TCPSegment>& segs,
+                                        const FdAdapterConfig& addresses) {
+  // 按上行丢包率逐段丢弃，被丢弃的报文隔断前后的合并
+  erase_if(segs, [&](const TCPSegment&) { return _should_drop(true); });
+  if (not _tun.offload()) {
+    for (auto& seg : segs) {
+      _tun.write(serialize(wrap_tcp_in_ip(seg, addresses)));
     }
-    return unwrap_tcp_in_ip(ip_dgram);
+    return;
   }
-  return {};
+
+  for (size_t i = 0; i < segs.size();) {
+    const size_t end = coalesce_run(segs, i);
+    write_offloaded(span{segs}.subspan(i, end - i), addresses);
+    i = end;
+  }
+}
+
+FourTuple FourTuple::of(const FdAdapterConfig& cfg) {
+  return {.local_address = cfg.source.ipv4_numeric(),
+          .local_port = cfg.source.port(),
+          .remote_address = cfg.destination.ipv4_numeric(),
+          .remote_port = cfg.destination.port()};
+}
+
+FdAdapterConfig FourTuple::addresses() const {
+  FdAdapterConfig cfg;
+  cfg.source =
+      Address(Address::from_ipv4_numeric(local_address).ip(), local_port);
+  cfg.destination =
+      Address(Address::from_ipv4_numeric(remote_address).ip(), remote_port);
+  return cfg;
+}
+
+size_t FourTupleHash::operator()(const FourTuple& tuple) const {
+  const uint64_t addresses =
+      (uint64_t{tuple.local_address} << 32) | tuple.remote_address;
+  const uint64_t ports =
+      (uint64_t{tuple.local_port} << 16) | tuple.remote_port;
+  // 乘以黄金分割常数打散端口，再与地址混合；最后用 splitmix64 的
+  // 终结步骤让每一位输入都影响高位，分片按高位选取
+  uint64_t h = addresses ^ (ports * 0x9e3779b97f4a7c15);
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+  return h ^ (h >> 31);
 }
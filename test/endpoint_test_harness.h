@@ -0,0 +1,241 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "common.h"
+#include "config/tcp_config.h"
+#include "connect/tcp_endpoint.h"
+
+/**
+ * @brief 被测试的 TCP 端点，由测试扮演对端
+ * 测试中的序列号均为对端的绝对序列号，由 peer_isn 换算为 Wrap32
+ */
+struct EndpointAndPeer {
+  Wrap32 isn;       //!< 端点的 ISN
+  Wrap32 peer_isn;  //!< 对端的 ISN
+  TCPEndpoint endpoint;
+};
+
+class EndpointTestHarness : public TestHarness<EndpointAndPeer> {
+ public:
+  EndpointTestHarness(std::string test_name, TCPConfig config)
+      : TestHarness(std::move(test_name),
+                    "ack_delay_ms=" + std::to_string(config.ack_delay_ms),
+                    make_object(config)) {}
+
+ private:
+  static EndpointAndPeer make_object(TCPConfig& config) {
+    if (!config.fixed_isn) {
+      config.fixed_isn = Wrap32{0x8000'0000};
+    }
+    return {config.fixed_isn.value(), Wrap32{0x4000'0000},
+            TCPEndpoint{config}};
+  }
+};
+
+/* actions */
+
+//! 对端发来的报文；SYN 之后的报文默认只确认端点的 SYN
+struct PeerSends : public Action<EndpointAndPeer> {
+  uint64_t seqno_;
+  std::string payload_;
+  bool syn_{};
+  bool fin_{};
+  bool sack_permitted_{};
+  uint64_t ackno_{1};
+
+  PeerSends(uint64_t seqno, std::string payload)
+      : seqno_(seqno), payload_(std::move(payload)) {}
+
+  PeerSends& with_syn() {
+    syn_ = true;
+    return *this;
+  }
+
+  PeerSends& with_fin() {
+    fin_ = true;
+    return *this;
+  }
+
+  //! 对端的 SYN 允许 SACK
+  PeerSends& with_sack_permitted() {
+    sack_permitted_ = true;
+    return *this;
+  }
+
+  //! 确认端点发出的数据，ackno 为端点的绝对序列号
+  PeerSends& with_ackno(uint64_t ackno) {
+    ackno_ = ackno;
+    return *this;
+  }
+
+  std::string description() const override {
+    return "peer sends segment @ " + std::to_string(seqno_) + " with " +
+           std::to_string(payload_.size()) + " bytes" +
+           (syn_ ? " [SYN]" : "") + (fin_ ? " [FIN]" : "");
+  }
+
+  void execute(EndpointAndPeer& ep) const override {
+    TCPSegment seg;
+    seg.sender_message = {.seqno = ep.peer_isn + seqno_,
+                          .SYN = syn_,
+                          .payload = std::string{payload_},
+                          .FIN = fin_,
+                          .sack_permitted = syn_ && sack_permitted_};
+    if (!syn_) {
+      seg.receiver_message.ackno = ep.isn + ackno_;
+    }
+    seg.receiver_message.window_size = 60000;
+    ep.endpoint.receive(std::move(seg));
+  }
+};
+
+struct EndpointTick : public Action<EndpointAndPeer> {
+  uint64_t ms_;
+
+  explicit EndpointTick(uint64_t ms) : ms_(ms) {}
+  std::string description() const override {
+    return "tick " + std::to_string(ms_) + " ms";
+  }
+  void execute(EndpointAndPeer& ep) const override { ep.endpoint.tick(ms_); }
+};
+
+struct AppWrites : public Action<EndpointAndPeer> {
+  std::string data_;
+
+  explicit AppWrites(std::string data) : data_(std::move(data)) {}
+  std::string description() const override {
+    return "application writes " + std::to_string(data_.size()) + " bytes";
+  }
+  void execute(EndpointAndPeer& ep) const override {
+    ep.endpoint.outbound_writer().push(data_);
+    ep.endpoint.push();
+  }
+};
+
+struct AppReads : public Action<EndpointAndPeer> {
+  uint64_t len_;
+
+  explicit AppReads(uint64_t len) : len_(len) {}
+  std::string description() const override {
+    return "application reads " + std::to_string(len_) + " bytes";
+  }
+  void execute(EndpointAndPeer& ep) const override {
+    std::string data;
+    read(ep.endpoint.inbound_reader(), len_, data);
+    if (data.size() != len_) {
+      throw ExpectationViolation{"bytes read", len_, uint64_t{data.size()}};
+    }
+  }
+};
+
+/* expectations */
+
+//! 端点发出的下一个报文确认到对端的 ackno，并携带 payload_size 字节
+struct ExpectAck : public Expectation<EndpointAndPeer> {
+  uint64_t ackno_;
+  size_t payload_size_{};
+  std::optional<uint32_t> window_{};
+  std::optional<size_t> sack_blocks_{};
+  std::optional<size_t> max_length_{};  //!< TCP 报头 (含选项) 与载荷的总长度
+
+  explicit ExpectAck(uint64_t ackno) : ackno_(ackno) {}
+
+  ExpectAck& with_payload_size(size_t size) {
+    payload_size_ = size;
+    return *this;
+  }
+
+  ExpectAck& with_window(uint32_t window) {
+    window_ = window;
+    return *this;
+  }
+
+  ExpectAck& with_sack_blocks(size_t blocks) {
+    sack_blocks_ = blocks;
+    return *this;
+  }
+
+  ExpectAck& with_max_length(size_t length) {
+    max_length_ = length;
+    return *this;
+  }
+
+  std::string description() const override {
+    return "segment with ackno " + std::to_string(ackno_) + " and " +
+           std::to_string(payload_size_) + " bytes" +
+           (window_ ? ", window " + std::to_string(window_.value()) : "");
+  }
+
+  void execute(EndpointAndPeer& ep) const override {
+    const auto seg = ep.endpoint.maybe_send();
+    if (!seg) {
+      throw ExpectationViolation{"expected a segment, but none was sent"};
+    }
+    if (!(seg->receiver_message.ackno == ep.peer_isn + ackno_)) {
+      throw ExpectationViolation{"segment has the wrong ackno"};
+    }
+    if (seg->sender_message.payload.size() != payload_size_) {
+      throw ExpectationViolation{"payload size", payload_size_,
+                                 seg->sender_message.payload.size()};
+    }
+    if (window_ && seg->receiver_message.window_size != window_.value()) {
+      throw ExpectationViolation{"window", window_.value(),
+                                 seg->receiver_message.window_size};
+    }
+    if (sack_blocks_ &&
+        seg->receiver_message.sack_blocks.size() != sack_blocks_.value()) {
+      throw ExpectationViolation{"SACK blocks", sack_blocks_.value(),
+                                 seg->receiver_message.sack_blocks.size()};
+    }
+    if (max_length_ && seg->header_length() +
+                               seg->sender_message.payload.size() >
+                           max_length_.value()) {
+      throw ExpectationViolation{"segment is longer than " +
+                                 std::to_string(max_length_.value())};
+    }
+  }
+};
+
+struct ExpectNothing : public Expectation<EndpointAndPeer> {
+  std::string description() const override { return "no segment to send"; }
+  void execute(EndpointAndPeer& ep) const override {
+    if (ep.endpoint.maybe_send()) {
+      throw ExpectationViolation{"expected no segment, but one was sent"};
+    }
+  }
+};
+
+struct AcksSaved : public ExpectNumber<EndpointAndPeer, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "acks_saved"; }
+  uint64_t value(EndpointAndPeer& ep) const override {
+    return ep.endpoint.stats().acks_saved;
+  }
+};
+
+struct RcvBuffer : public ExpectNumber<EndpointAndPeer, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rcv_buffer"; }
+  uint64_t value(EndpointAndPeer& ep) const override {
+    return ep.endpoint.stats().rcv_buffer;
+  }
+};
+
+struct SndBuffer : public ExpectNumber<EndpointAndPeer, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "snd_buffer"; }
+  uint64_t value(EndpointAndPeer& ep) const override {
+    return ep.endpoint.stats().snd_buffer;
+  }
+};
+
+struct HeaderPredicted : public ExpectNumber<EndpointAndPeer, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "header_predicted"; }
+  uint64_t value(EndpointAndPeer& ep) const override {
+    return ep.endpoint.stats().header_predicted;
+  }
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include "common.h"
+#include "congestion/pacer.h"
+
+class PacerTestHarness : public TestHarness<Pacer> {
+ public:
+  explicit PacerTestHarness(std::string test_name)
+      : TestHarness(std::move(test_name), "no rate", Pacer{}) {}
+};
+
+/* actions */
+
+struct SetRate : public Action<Pacer> {
+  uint64_t now_us_;
+  uint64_t rate_;
+  uint64_t burst_;
+
+  SetRate(uint64_t now_us, uint64_t rate, uint64_t burst)
+      : now_us_(now_us), rate_(rate), burst_(burst) {}
+  std::string description() const override {
+    return "at " + std::to_string(now_us_) + " us set rate " +
+           std::to_string(rate_) + " B/s, burst " + std::to_string(burst_);
+  }
+  void execute(Pacer& pacer) const override {
+    pacer.set_rate(now_us_, rate_, burst_);
+  }
+};
+
+/* expectations */
+
+struct TrySend : public ExpectBool<Pacer> {
+  uint64_t now_us_;
+  uint64_t bytes_;
+
+  TrySend(uint64_t now_us, uint64_t bytes, bool sent)
+      : ExpectBool(sent), now_us_(now_us), bytes_(bytes) {}
+  std::string name() const override {
+    return "at " + std::to_string(now_us_) + " us try_send(" +
+           std::to_string(bytes_) + ")";
+  }
+  bool value(Pacer& pacer) const override {
+    return pacer.try_send(now_us_, bytes_);
+  }
+};
+
+struct DelayUs : public ExpectNumber<Pacer, uint64_t> {
+  uint64_t bytes_;
+
+  DelayUs(uint64_t bytes, uint64_t delay_us)
+      : ExpectNumber(delay_us), bytes_(bytes) {}
+  std::string name() const override {
+    return "delay_us(" + std::to_string(bytes_) + ")";
+  }
+  uint64_t value(Pacer& pacer) const override {
+    return pacer.delay_us(bytes_);
+  }
+};
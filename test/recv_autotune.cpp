@@ -0,0 +1,93 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "endpoint_test_harness.h"
+
+using namespace std;
+
+//! 完成握手，端点测得 10 ms 的 RTT
+static void handshake(EndpointTestHarness& test) {
+  test.execute(PeerSends{0, ""}.with_syn());
+  test.execute(ExpectAck{1});
+  test.execute(EndpointTick{10});
+  test.execute(PeerSends{1, ""});
+}
+
+int main() {
+  try {
+    const string segment(2000, 'x');
+
+    {
+      TCPConfig cfg;
+      cfg.recv_capacity = 4000;
+      cfg.max_recv_capacity = 12000;
+      cfg.ack_delay_ms = 0;
+      EndpointTestHarness test{"buffer follows the rate the app reads", cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1, segment});
+      test.execute(ExpectAck{2001}.with_window(2000));
+      test.execute(PeerSends{2001, segment});
+      test.execute(ExpectAck{4001}.with_window(0));
+      test.execute(AppReads{4000});
+
+      // 一个 RTT 内读取 4000 字节，缓冲区增长到两倍
+      test.execute(EndpointTick{10});
+      test.execute(RcvBuffer{8000});
+
+      for (uint64_t seqno = 4001; seqno < 12001; seqno += 2000) {
+        test.execute(PeerSends{seqno, segment});
+        test.execute(ExpectAck{seqno + 2000});
+      }
+      test.execute(AppReads{8000});
+      // 不超过上限
+      test.execute(EndpointTick{10});
+      test.execute(RcvBuffer{12000});
+
+      // 重复的报文立即确认，通告完整的窗口
+      test.execute(PeerSends{1, segment});
+      test.execute(ExpectAck{12001}.with_window(12000));
+
+      // 空闲后缩回初始大小，但不收回已通告的窗口
+      for (int i = 0; i < 100; i++) {
+        test.execute(EndpointTick{10});
+      }
+      test.execute(RcvBuffer{12000});
+
+      test.execute(PeerSends{12001, string(1000, 'x')});
+      test.execute(ExpectAck{13001}.with_window(11000));
+      test.execute(AppReads{1000});
+      test.execute(EndpointTick{10});
+      test.execute(RcvBuffer{11000});
+
+      // 窗口的右边界保持不动，随应用读取逐步缩小
+      test.execute(PeerSends{13001, segment});
+      test.execute(ExpectAck{15001}.with_window(9000));
+      test.execute(AppReads{2000});
+      test.execute(EndpointTick{10});
+      test.execute(RcvBuffer{9000});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.recv_capacity = 4000;
+      cfg.rcvbuf_autotune = false;
+      cfg.ack_delay_ms = 0;
+      EndpointTestHarness test{"fixed buffer without auto-tuning", cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1, segment});
+      test.execute(ExpectAck{2001}.with_window(2000));
+      test.execute(AppReads{2000});
+      test.execute(EndpointTick{10});
+      test.execute(EndpointTick{10});
+      test.execute(RcvBuffer{4000});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
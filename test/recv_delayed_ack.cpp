@@ -0,0 +1,114 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "endpoint_test_harness.h"
+
+using namespace std;
+
+//! 完成握手：对端的 SYN 与端点的 SYN/ACK
+static void handshake(EndpointTestHarness& test) {
+  test.execute(PeerSends{0, ""}.with_syn());
+  test.execute(ExpectAck{1});
+  test.execute(PeerSends{1, ""});
+  test.execute(ExpectNothing{});
+}
+
+int main() {
+  try {
+    const string segment(1000, 'x');
+
+    {
+      TCPConfig cfg;
+      EndpointTestHarness test{"ack every second segment", cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1, segment});
+      test.execute(ExpectNothing{});
+      test.execute(PeerSends{1001, segment});
+      test.execute(ExpectAck{2001});
+      test.execute(AcksSaved{1});
+
+      test.execute(PeerSends{2001, segment});
+      test.execute(PeerSends{3001, segment});
+      test.execute(ExpectAck{4001});
+      test.execute(ExpectNothing{});
+      test.execute(AcksSaved{2});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.ack_delay_ms = 100;
+      EndpointTestHarness test{"lone segment is acked after the delay", cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1, segment});
+      test.execute(EndpointTick{99});
+      test.execute(ExpectNothing{});
+      test.execute(EndpointTick{1});
+      test.execute(ExpectAck{1001});
+      test.execute(EndpointTick{1000});
+      test.execute(ExpectNothing{});
+      test.execute(AcksSaved{0});
+    }
+
+    {
+      TCPConfig cfg;
+      EndpointTestHarness test{"out-of-order data is acked at once", cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1001, segment});
+      test.execute(ExpectAck{1});
+      // 填补空洞的报文也立即确认
+      test.execute(PeerSends{1, segment});
+      test.execute(ExpectAck{2001});
+      // 重复的报文
+      test.execute(PeerSends{1, segment});
+      test.execute(ExpectAck{2001});
+      test.execute(AcksSaved{0});
+    }
+
+    {
+      TCPConfig cfg;
+      EndpointTestHarness test{"FIN is acked at once", cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1, segment});
+      test.execute(PeerSends{1001, "abc"}.with_fin());
+      test.execute(ExpectAck{1005});
+      test.execute(AcksSaved{1});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.ack_delay_ms = 10;
+      EndpointTestHarness test{"ACK rides on outgoing data", cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1, segment});
+      test.execute(AppWrites{"hello"});
+      test.execute(ExpectAck{1001}.with_payload_size(5));
+      // 延迟确认的计时随之取消
+      test.execute(EndpointTick{10});
+      test.execute(ExpectNothing{});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.ack_delay_ms = 0;
+      EndpointTestHarness test{"zero delay acks every segment", cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1, segment});
+      test.execute(ExpectAck{1001});
+      test.execute(PeerSends{1001, segment});
+      test.execute(ExpectAck{2001});
+      test.execute(AcksSaved{0});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "endpoint_test_harness.h"
+
+using namespace std;
+
+//! 完成握手：对端的 SYN 与端点的 SYN/ACK
+static void handshake(EndpointTestHarness& test) {
+  test.execute(PeerSends{0, ""}.with_syn());
+  test.execute(ExpectAck{1});
+  test.execute(PeerSends{1, ""});
+}
+
+int main() {
+  try {
+    const string segment(1000, 'x');
+
+    {
+      TCPConfig cfg;
+      EndpointTestHarness test{"in-order data takes the fast path", cfg};
+      handshake(test);
+      // 确认 SYN 的 ACK 推进了 snd.una
+      test.execute(HeaderPredicted{1});
+
+      test.execute(PeerSends{1, segment});
+      test.execute(PeerSends{1001, segment});
+      test.execute(HeaderPredicted{3});
+      test.execute(ExpectAck{2001});
+      test.execute(AppReads{2000});
+
+      // 乱序到达的报文和填补空洞的报文走完整路径
+      test.execute(PeerSends{3001, segment});
+      test.execute(ExpectAck{2001});
+      test.execute(PeerSends{2001, segment});
+      test.execute(ExpectAck{4001});
+      test.execute(HeaderPredicted{3});
+
+      test.execute(PeerSends{4001, segment});
+      test.execute(HeaderPredicted{4});
+
+      // FIN 走完整路径
+      test.execute(PeerSends{5001, segment}.with_fin());
+      test.execute(HeaderPredicted{4});
+      test.execute(ExpectAck{6002});
+      test.execute(AppReads{3000});
+    }
+
+    {
+      TCPConfig cfg;
+      EndpointTestHarness test{"ACK advancing snd.una takes the fast path",
+                               cfg};
+      handshake(test);
+
+      // 对端的 SYN 没有通告 MSS，按 536 字节分段
+      test.execute(AppWrites{string(1000, 'y')});
+      test.execute(ExpectAck{1}.with_payload_size(536));
+      test.execute(ExpectNothing{});
+
+      test.execute(PeerSends{1, ""}.with_ackno(537));
+      test.execute(HeaderPredicted{2});
+      test.execute(ExpectAck{1}.with_payload_size(464));
+      // 重复 ACK 走完整路径
+      test.execute(PeerSends{1, ""}.with_ackno(537));
+      test.execute(HeaderPredicted{2});
+      test.execute(PeerSends{1, ""}.with_ackno(1001));
+      test.execute(HeaderPredicted{3});
+      test.execute(ExpectNothing{});
+
+      // 本端有在途数据时，对端的数据报文走完整路径
+      test.execute(AppWrites{"z"});
+      test.execute(ExpectAck{1}.with_payload_size(1));
+      test.execute(PeerSends{1, segment}.with_ackno(1001));
+      test.execute(HeaderPredicted{3});
+      test.execute(PeerSends{1001, segment}.with_ackno(1002));
+      test.execute(HeaderPredicted{3});
+      test.execute(PeerSends{2001, segment}.with_ackno(1002));
+      test.execute(HeaderPredicted{4});
+      test.execute(AppReads{3000});
+    }
+
+    {
+      TCPConfig cfg;
+      EndpointTestHarness test{"data repeating the ackno is not a dup ACK",
+                               cfg};
+      handshake(test);
+
+      test.execute(AppWrites{string(5 * 536, 'y')});
+      for (int i = 0; i < 5; i++) {
+        test.execute(ExpectAck{1}.with_payload_size(536));
+      }
+      test.execute(ExpectNothing{});
+
+      // 对端的数据报文重复 ackno，不触发快速重传
+      for (uint64_t seqno = 1; seqno < 5001; seqno += 1000) {
+        test.execute(PeerSends{seqno, segment});
+      }
+      test.execute(ExpectAck{5001});
+      test.execute(ExpectNothing{});
+      test.execute(AppReads{5000});
+
+      // 三个纯重复 ACK 触发快速重传
+      test.execute(PeerSends{5001, ""});
+      test.execute(PeerSends{5001, ""});
+      test.execute(ExpectNothing{});
+      test.execute(PeerSends{5001, ""});
+      test.execute(ExpectAck{5001}.with_payload_size(536));
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
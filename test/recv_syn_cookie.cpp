@@ -0,0 +1,123 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "common.h"
+#include "config/tcp_config.h"
+#include "connect/syn_cookie.h"
+
+using namespace std;
+
+static void expect(const bool condition, const string& what) {
+  if (!condition) {
+    throw ExpectationViolation(what);
+  }
+}
+
+static TCPSegment make_syn(const Wrap32 isn, const uint16_t mss) {
+  TCPSegment syn;
+  syn.sender_message = {.seqno = isn,
+                        .SYN = true,
+                        .mss = mss,
+                        .sack_permitted = true,
+                        .window_scale = 7,
+                        .ts_val = 1000};
+  return syn;
+}
+
+static TCPSegment make_ack(const Wrap32 isn, const Wrap32 cookie,
+                           const string& payload = "") {
+  TCPSegment ack;
+  ack.sender_message = {.seqno = isn + 1, .payload = string(payload)};
+  ack.receiver_message = {.ackno = cookie + 1, .window_size = 1000};
+  return ack;
+}
+
+int main() {
+  try {
+    const FourTuple tuple{.local_address = 0xa9fe9009,
+                          .local_port = 9000,
+                          .remote_address = 0xa9fe9001,
+                          .remote_port = 40000};
+    const Wrap32 peer_isn{0x1234'5678};
+    const uint64_t now = 10 * TCPConfig::SYN_COOKIE_PERIOD_MS;
+
+    TCPConfig cfg;
+    cfg.mss = 1460;
+    const SynCookies cookies{cfg};
+
+    // SYN-ACK 只带能编码进 cookie 的选项，同样的 SYN 得到同样的 cookie
+    const TCPSegment syn_ack =
+        cookies.syn_ack(tuple, make_syn(peer_isn, 1300), now);
+    const TCPSenderMessage& msg = syn_ack.sender_message;
+    expect(msg.SYN && syn_ack.receiver_message.ackno == peer_isn + 1,
+           "SYN-ACK should acknowledge the SYN");
+    expect(msg.mss == 1460 && msg.sack_permitted,
+           "SYN-ACK should carry MSS and SACK-Permitted");
+    expect(!msg.window_scale && !msg.ts_val,
+           "SYN-ACK should not carry window scale or timestamps");
+    expect(cookies.syn_ack(tuple, make_syn(peer_isn, 1300), now)
+                   .sender_message.seqno == msg.seqno,
+           "cookie should not depend on any saved state");
+
+    // 有效的 ACK 重建连接，一并处理其中的数据
+    {
+      auto tcp = cookies.accept(tuple, make_ack(peer_isn, msg.seqno, "hi"),
+                                now + 1);
+      expect(tcp.has_value(), "valid cookie should be accepted");
+      expect(tcp->has_ackno() &&
+                 !tcp->transceiver().sequence_numbers_in_flight(),
+             "restored connection should be established");
+      expect(tcp->inbound_reader().peek() == "hi",
+             "data in the final ACK should be delivered");
+      expect(!tcp->transceiver().srtt_ms(),
+             "handshake should not produce an RTT sample");
+      expect(tcp->stats().mss == 1300,
+             "MSS should be restored from the cookie");
+    }
+
+    // cookie 在发出的周期和下一个周期内有效
+    expect(cookies
+               .accept(tuple, make_ack(peer_isn, msg.seqno),
+                       now + TCPConfig::SYN_COOKIE_PERIOD_MS)
+               .has_value(),
+           "cookie from the previous period should be accepted");
+    expect(!cookies
+                .accept(tuple, make_ack(peer_isn, msg.seqno),
+                        now + 2 * TCPConfig::SYN_COOKIE_PERIOD_MS)
+                .has_value(),
+           "expired cookie should be rejected");
+
+    // 四元组、对端 ISN 或 cookie 不符
+    FourTuple other = tuple;
+    other.remote_port += 1;
+    expect(!cookies.accept(other, make_ack(peer_isn, msg.seqno), now)
+                .has_value(),
+           "cookie for another 4-tuple should be rejected");
+    expect(!cookies.accept(tuple, make_ack(peer_isn + 1, msg.seqno), now)
+                .has_value(),
+           "cookie for another ISN should be rejected");
+    expect(!cookies.accept(tuple, make_ack(peer_isn, msg.seqno + 1), now)
+                .has_value(),
+           "forged cookie should be rejected");
+    expect(!SynCookies{cfg}
+                .accept(tuple, make_ack(peer_isn, msg.seqno), now)
+                .has_value(),
+           "cookie from another key should be rejected");
+
+    // 表中没有的 MSS 向下取整，不超过对端的 MSS
+    const TCPSegment small =
+        cookies.syn_ack(tuple, make_syn(peer_isn, 1000), now);
+    auto tcp = cookies.accept(
+        tuple, make_ack(peer_isn, small.sender_message.seqno), now);
+    expect(tcp.has_value() && tcp->stats().mss == 536,
+           "MSS should be rounded down to the table");
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
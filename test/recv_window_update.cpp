@@ -0,0 +1,50 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "endpoint_test_harness.h"
+
+using namespace std;
+
+int main() {
+  try {
+    {
+      TCPConfig cfg;
+      cfg.recv_capacity = 4000;
+      cfg.mss = 1000;
+      cfg.ack_delay_ms = 0;
+      cfg.rcvbuf_autotune = false;
+      EndpointTestHarness test{"reader reopens a closed window", cfg};
+
+      test.execute(PeerSends{0, ""}.with_syn());
+      test.execute(ExpectAck{1});
+      test.execute(PeerSends{1, string(4000, 'x')});
+      test.execute(ExpectAck{4001}.with_window(0));
+
+      // 对端的窗口探测 (snd.nxt - 1) 立即得到确认
+      test.execute(PeerSends{4000, ""});
+      test.execute(ExpectAck{4001}.with_window(0));
+
+      // 不到一个 MSS 的空间不通告
+      test.execute(AppReads{500});
+      test.execute(ExpectNothing{});
+      test.execute(AppReads{500});
+      test.execute(ExpectAck{4001}.with_window(1000));
+
+      // 窗口至少翻倍时再次更新
+      test.execute(AppReads{1000});
+      test.execute(ExpectAck{4001}.with_window(2000));
+      test.execute(AppReads{100});
+      test.execute(ExpectNothing{});
+
+      // 普通的 ACK 也不通告右边界的小幅前进
+      test.execute(PeerSends{4001, string(100, 'x')});
+      test.execute(ExpectAck{4101}.with_window(1900));
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "endpoint_test_harness.h"
+
+using namespace std;
+
+//! 完成握手：对端的 SYN 与端点的 SYN/ACK
+static void handshake(EndpointTestHarness& test) {
+  test.execute(PeerSends{0, ""}.with_syn());
+  test.execute(ExpectAck{1});
+  test.execute(PeerSends{1, ""});
+}
+
+int main() {
+  try {
+    {
+      TCPConfig cfg;
+      cfg.send_capacity = 4000;
+      cfg.mss = 536;
+      EndpointTestHarness test{"buffer follows the send window", cfg};
+      test.execute(SndBuffer{4000});
+      handshake(test);
+
+      // 初始窗口为 10 个 MSS，确认 SYN 又在慢启动中增加了 1 字节
+      test.execute(SndBuffer{2 * 5361});
+
+      test.execute(AppWrites{string(5360, 'y')});
+      for (int i = 0; i < 10; i++) {
+        test.execute(ExpectAck{1}.with_payload_size(536));
+      }
+      test.execute(ExpectNothing{});
+
+      // 慢启动中窗口随确认增长 (每个 ACK 至多 2 个 MSS，RFC 3465)，
+      // 缓冲区随之扩大
+      test.execute(PeerSends{1, ""}.with_ackno(5361));
+      test.execute(SndBuffer{2 * (5361 + 2 * 536)});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.send_capacity = 4000;
+      cfg.mss = 536;
+      cfg.max_send_capacity = 6000;
+      EndpointTestHarness test{"buffer stays below the limit", cfg};
+      handshake(test);
+      test.execute(SndBuffer{6000});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.send_capacity = 4000;
+      cfg.sndbuf_autotune = false;
+      EndpointTestHarness test{"fixed buffer without auto-tuning", cfg};
+      handshake(test);
+      test.execute(SndBuffer{4000});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
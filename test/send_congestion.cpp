@@ -0,0 +1,181 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "transceiver_test_harness.h"
+
+using namespace std;
+
+int main() {
+  try {
+    const string data(20000, 'x');
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.congestion_control = CongestionAlgorithm::NewReno;
+      TransceiverTestHarness test{"NewReno slow start and loss", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(Cwnd{10001});
+
+      // 拥塞窗口而不是接收窗口限制了发送量
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 10001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+      test.execute(ExpectNoSegment{});
+
+      // 慢启动：每确认一个报文发送两个
+      test.execute(ReceiveAck{1001, 60000});
+      test.execute(Cwnd{11001});
+      test.execute(ExpectSegment{10001, 1000});
+      test.execute(ExpectSegment{11001, 1000});
+      test.execute(ExpectNoSegment{});
+
+      // 2001 丢失，之后的三个报文被 SACK
+      test.execute(ReceiveAck{2001, 60000}.with_sack(3001, 6001));
+      test.execute(InRecovery{true});
+      test.execute(Ssthresh{5000});
+      test.execute(Cwnd{5000});
+      test.execute(ExpectSegment{2001, 1000});
+      test.execute(ExpectNoSegment{});
+
+      // 恢复期间窗口不增长
+      test.execute(ReceiveAck{6001, 60000});
+      test.execute(Cwnd{5000});
+      test.execute(ReceiveAck{12001, 60000});
+      test.execute(InRecovery{false});
+      test.execute(Cwnd{5000});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.congestion_control = CongestionAlgorithm::Cubic;
+      TransceiverTestHarness test{"CUBIC multiplicative decrease", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 10001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+
+      test.execute(ReceiveAck{1, 60000}.with_sack(1001, 4001));
+      test.execute(InRecovery{true});
+      test.execute(Cwnd{7000});
+      test.execute(ExpectSegment{1, 1000});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.rt_timeout = 100;
+      cfg.congestion_control = CongestionAlgorithm::NewReno;
+      TransceiverTestHarness test{"RTO collapses the window to one MSS", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 10001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+      test.execute(Tick{100});
+      test.execute(Cwnd{1000});
+      test.execute(Ssthresh{5000});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(ExpectNoSegment{});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.congestion_control = CongestionAlgorithm::NewReno;
+      TransceiverTestHarness test{"NewReno fast recovery on duplicate ACKs",
+                                  cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 10001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+
+      // 1 和 4001 丢失，对端不支持 SACK，只能发送重复 ACK
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(InRecovery{false});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(InRecovery{true});
+      test.execute(Ssthresh{5000});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(ExpectNoSegment{});
+
+      // 之后的每个重复 ACK 使窗口膨胀一个 MSS
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(ExpectNoSegment{});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(ExpectSegment{10001, 1000});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(ExpectSegment{11001, 1000});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(ExpectSegment{12001, 1000});
+      test.execute(ExpectNoSegment{});
+
+      // 部分确认立即重传下一个空洞
+      test.execute(ReceiveAck{4001, 60000});
+      test.execute(InRecovery{true});
+      test.execute(ExpectSegment{4001, 1000});
+      test.execute(ExpectNoSegment{});
+      test.execute(ReceiveAck{4001, 60000});
+      test.execute(ExpectNoSegment{});
+
+      // 完全确认后退出恢复，窗口收缩到 ssthresh
+      test.execute(ReceiveAck{13001, 60000});
+      test.execute(InRecovery{false});
+      test.execute(Cwnd{5000});
+      for (uint64_t seqno = 13001; seqno < 18001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+      test.execute(ExpectNoSegment{});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.congestion_control = CongestionAlgorithm::Bbr;
+      TransceiverTestHarness test{"BBR paces at the sampled delivery rate",
+                                  cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Tick{10});
+      test.execute(ReceiveAck{1, 60000});
+
+      test.execute(PushData{string(10000, 'x')});
+      for (uint64_t seqno = 1; seqno < 10001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+      test.execute(Tick{10});
+      test.execute(ReceiveAck{10001, 60000});
+
+      // 10 ms 内交付 10000 字节
+      test.execute(DeliveryRate{1000000});
+      test.execute(PacingRate{2885000});
+      // 慢启动阶段按确认量增长
+      test.execute(Cwnd{20001});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
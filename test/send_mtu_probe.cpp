@@ -0,0 +1,105 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "transceiver_test_harness.h"
+
+using namespace std;
+
+int main() {
+  try {
+    const string probe(1242, 'x');
+
+    {
+      TCPConfig cfg;
+      cfg.mtu_probing = true;
+      cfg.timestamps = false;
+      TransceiverTestHarness test{"acked probe raises the MSS", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_mss(1460));
+      test.execute(ReceiveSegment{0, ""}.with_syn(true).with_mss(1460));
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(Mss{1024});
+
+      // 在 [1024, 1460] 的中点探测
+      test.execute(PushData{probe});
+      test.execute(ExpectSegment{1, 1242});
+      test.execute(ReceiveAck{1243, 60000});
+      test.execute(Mss{1242});
+      test.execute(MtuProbes{1});
+
+      // 数据不足一个探测报文时按当前的 MSS 发送
+      test.execute(PushData{string(1300, 'x')});
+      test.execute(ExpectSegment{1243, 1242});
+      // Nagle：剩下的小报文等待确认
+      test.execute(ExpectNoSegment{});
+      test.execute(ReceiveAck{2485, 60000});
+      test.execute(ExpectSegment{2485, 58});
+      test.execute(MtuProbes{1});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mtu_probing = true;
+      cfg.timestamps = false;
+      TransceiverTestHarness test{"lost probe is split and not a congestion "
+                                  "signal",
+                                  cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveSegment{0, ""}.with_syn(true).with_mss(1460));
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(Cwnd{10241});
+
+      test.execute(PushData{string(20000, 'x')});
+      test.execute(ExpectSegment{1, 1242});
+      for (uint64_t seqno = 1243; seqno < 9435; seqno += 1024) {
+        test.execute(ExpectSegment{seqno, 1024});
+      }
+      test.execute(ExpectNoSegment{});
+
+      // 探测之后的报文都已到达
+      test.execute(ReceiveAck{1, 60000}.with_sack(1243, 9435));
+      test.execute(InRecovery{true});
+      test.execute(Cwnd{10241});
+      test.execute(Mss{1024});
+      test.execute(ExpectSegment{1, 1024});
+      test.execute(ExpectSegment{1025, 218});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mtu_probing = true;
+      cfg.timestamps = false;
+      TransceiverTestHarness test{"repeated timeouts fall back to the base MSS",
+                                  cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveSegment{0, ""}.with_syn(true).with_mss(1460));
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(PushData{probe});
+      test.execute(ExpectSegment{1, 1242});
+      test.execute(ReceiveAck{1243, 60000});
+      test.execute(Mss{1242});
+
+      // 路径 MTU 变小：大报文连续超时后退回 1024 字节并拆分重传
+      test.execute(PushData{string(1242, 'x')});
+      test.execute(ExpectSegment{1243, 1242});
+      test.execute(Tick{20});
+      test.execute(ExpectSegment{1243, 1242});
+      test.execute(Tick{40});
+      test.execute(Mss{1024});
+      test.execute(ExpectSegment{1243, 1024});
+      test.execute(ReceiveAck{2267, 60000});
+      test.execute(ExpectSegment{2267, 218});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "transceiver_test_harness.h"
+
+using namespace std;
+
+//! 完成握手，对端通告 60000 字节的窗口
+static void handshake(TransceiverTestHarness& test) {
+  test.execute(PushData{});
+  test.execute(ExpectSegment{0, 0}.with_syn());
+  test.execute(ReceiveAck{1, 60000});
+}
+
+int main() {
+  try {
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      TransceiverTestHarness test{"Nagle coalesces small writes", cfg};
+      handshake(test);
+
+      // 没有在途数据时立即发送
+      test.execute(PushData{"a"});
+      test.execute(ExpectSegment{1, 1});
+      test.execute(PushData{"b"});
+      test.execute(PushData{"c"});
+      test.execute(ExpectNoSegment{});
+
+      // 确认到达后合并成一个报文
+      test.execute(ReceiveAck{2, 60000});
+      test.execute(ExpectSegment{2, 2});
+      test.execute(ExpectNoSegment{});
+
+      // 凑满 MSS 的报文不受限制，剩下的部分继续等待
+      test.execute(PushData{string(2500, 'x')});
+      test.execute(ExpectSegment{4, 1000});
+      test.execute(ExpectSegment{1004, 1000});
+      test.execute(ExpectNoSegment{});
+      test.execute(ReceiveAck{2004, 60000});
+      test.execute(ExpectSegment{2004, 500});
+
+      // 流结束时最后的小报文立即发送
+      test.execute(PushData{"end"}.with_close());
+      test.execute(ExpectSegment{2504, 3}.with_fin());
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.nodelay = true;
+      TransceiverTestHarness test{"nodelay sends every write", cfg};
+      handshake(test);
+
+      test.execute(PushData{"a"});
+      test.execute(ExpectSegment{1, 1});
+      test.execute(PushData{"b"});
+      test.execute(ExpectSegment{2, 1});
+      test.execute(PushData{"c"});
+      test.execute(ExpectSegment{3, 1});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.cork = true;
+      cfg.cork_timeout_ms = 200;
+      TransceiverTestHarness test{"cork holds partial segments", cfg};
+      handshake(test);
+
+      // 即使没有在途数据也等待
+      test.execute(PushData{string(300, 'x')});
+      test.execute(ExpectNoSegment{});
+      test.execute(PushData{string(300, 'x')});
+      test.execute(Tick{199});
+      test.execute(PushData{});
+      test.execute(ExpectNoSegment{});
+
+      // 超时后发送
+      test.execute(Tick{1});
+      test.execute(PushData{});
+      test.execute(ExpectSegment{1, 600});
+
+      // 凑满 MSS 后立即发送
+      test.execute(ReceiveAck{601, 60000});
+      test.execute(PushData{string(700, 'x')});
+      test.execute(ExpectNoSegment{});
+      test.execute(PushData{string(300, 'x')});
+      test.execute(ExpectSegment{601, 1000});
+
+      // 计时从新的数据被挡住时重新开始
+      test.execute(ReceiveAck{1601, 60000});
+      test.execute(PushData{string(10, 'x')});
+      test.execute(Tick{100});
+      test.execute(PushData{});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{100});
+      test.execute(PushData{});
+      test.execute(ExpectSegment{1601, 10});
+
+      // 解除 cork 后按 Nagle 算法发送
+      test.execute(ReceiveAck{1611, 60000});
+      test.execute(PushData{string(10, 'x')});
+      test.execute(ExpectNoSegment{});
+      test.execute(SetCork{false});
+      test.execute(ExpectSegment{1611, 10});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
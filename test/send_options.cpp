@@ -0,0 +1,171 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "transceiver_test_harness.h"
+
+using namespace std;
+
+int main() {
+  try {
+    const string data(20000, 'x');
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.recv_capacity = 1 << 20;
+      TransceiverTestHarness test{"window scaling is negotiated on SYN", cfg};
+
+      // 1 MiB 的接收缓冲区需要右移 5 位才能放进 16 位的窗口字段
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_window_scale(5));
+      test.execute(ReceiveSegment{0, ""}
+                       .with_syn(true)
+                       .with_mss(1000)
+                       .with_window_scale(3));
+
+      // 双方都带有该选项：对端的窗口左移 3 位，本端的窗口右移 5 位
+      test.execute(ReceiveAck{1, 1000});
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 8001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+      test.execute(ExpectNoSegment{});
+      test.execute(ExpectWindowField{(1 << 20) >> 5});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.recv_capacity = 1 << 20;
+      TransceiverTestHarness test{"no window scaling unless both sides agree",
+                                  cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_window_scale(5));
+      test.execute(ReceiveSegment{0, ""}.with_syn(true).with_mss(1000));
+
+      test.execute(ReceiveAck{1, 1000});
+      test.execute(PushData{data});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(ExpectNoSegment{});
+      test.execute(ExpectWindowField{UINT16_MAX});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.recv_capacity = 1 << 20;
+      TransceiverTestHarness test{"passive open answers only a scaled SYN",
+                                  cfg};
+
+      test.execute(ReceiveSegment{0, ""}.with_syn(true));
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_window_scale({}));
+    }
+
+    {
+      TCPConfig cfg;
+      TransceiverTestHarness test{"timestamps are echoed and guard with PAWS",
+                                  cfg};
+
+      test.execute(
+          ReceiveSegment{0, ""}.with_syn(true).with_ts_val(0xffff'fff0));
+      test.execute(ExpectTsEcr{0xffff'fff0});
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_ts_val(0));
+
+      // 只有按序到达的报文更新回显的时间戳
+      test.execute(ReceiveSegment{1, "abc"}.with_ts_val(0xffff'fff8));
+      test.execute(ExpectTsEcr{0xffff'fff8});
+      test.execute(ReceiveSegment{10, "x"}.with_ts_val(0xffff'fffa));
+      test.execute(ExpectTsEcr{0xffff'fff8});
+
+      // 时间戳回绕之后仍然比较新
+      test.execute(ReceiveSegment{4, "def"}.with_ts_val(0x10));
+      test.execute(BytesReceived{6});
+      test.execute(ExpectTsEcr{0x10});
+
+      // 比已记录的时间戳旧的报文被丢弃
+      test.execute(ReceiveSegment{7, "ghi"}.with_ts_val(0xffff'ffff));
+      test.execute(BytesReceived{6});
+      test.execute(ExpectTsEcr{0x10});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      TransceiverTestHarness test{"timestamps measure RTT of retransmissions",
+                                  cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_ts_val(0));
+      test.execute(
+          ReceiveSegment{0, ""}.with_syn(true).with_mss(1000).with_ts_val(1));
+      test.execute(Tick{10});
+      test.execute(ReceiveAck{1, 60000}.with_ts_ecr(0));
+      test.execute(Rto{30});
+
+      // 时间戳选项占用了 12 字节的载荷
+      test.execute(PushData{string(988, 'x')});
+      test.execute(ExpectSegment{1, 988}.with_ts_val(10));
+      test.execute(Tick{30});
+      test.execute(ExpectSegment{1, 988}.with_ts_val(40));
+      test.execute(Rto{60});
+
+      // Karn 算法会丢弃该样本；回显的 TSecr 说明它确认的是重传的报文
+      // SRTT = 11.25, RTTVAR = 6.25
+      test.execute(Tick{20});
+      test.execute(ReceiveAck{989, 60000}.with_ts_ecr(40));
+      test.execute(Rto{37});
+    }
+
+    {
+      TCPConfig cfg;
+      TransceiverTestHarness test{"passive open answers only a stamped SYN",
+                                  cfg};
+
+      test.execute(ReceiveSegment{0, ""}.with_syn(true));
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_ts_val({}));
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.timestamps = false;
+      TransceiverTestHarness test{"segments use the smaller MSS", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_mss(1460));
+      test.execute(ReceiveSegment{0, ""}.with_syn(true).with_mss(1200));
+
+      // 初始窗口按协商的 MSS 计算
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(Cwnd{12001});
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 12001; seqno += 1200) {
+        test.execute(ExpectSegment{seqno, 1200});
+      }
+      test.execute(ExpectNoSegment{});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.timestamps = false;
+      TransceiverTestHarness test{"peer without MSS option gets 536 bytes",
+                                  cfg};
+
+      test.execute(ReceiveSegment{0, ""}.with_syn(true));
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn().with_mss(1460));
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(PushData{data});
+      test.execute(ExpectSegment{1, 536});
+      test.execute(ExpectSegment{537, 536});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "pacer_test_harness.h"
+#include "transceiver_test_harness.h"
+
+using namespace std;
+
+int main() {
+  try {
+    {
+      PacerTestHarness test{"token bucket spaces out a burst"};
+
+      // 1 MB/s，桶容量两个报文
+      test.execute(SetRate{0, 1000000, 3000});
+      test.execute(TrySend{0, 1500, true});
+      test.execute(TrySend{0, 1500, true});
+      test.execute(TrySend{0, 1500, false});
+      test.execute(DelayUs{1500, 1500});
+      test.execute(TrySend{1000, 1500, false});
+      test.execute(DelayUs{1500, 500});
+      test.execute(TrySend{1500, 1500, true});
+
+      // 空闲再久也只积累一个桶的令牌
+      test.execute(TrySend{1000000, 1500, true});
+      test.execute(TrySend{1000000, 1500, true});
+      test.execute(TrySend{1000000, 1500, false});
+    }
+
+    {
+      PacerTestHarness test{"oversized segment waits for a full bucket"};
+
+      test.execute(SetRate{0, 1000000, 3000});
+      test.execute(TrySend{0, 1000, true});
+      test.execute(TrySend{0, 9000, false});
+      test.execute(DelayUs{9000, 1000});
+      // 桶满时放行，令牌透支，之后的报文等待更久
+      test.execute(TrySend{1000, 9000, true});
+      test.execute(TrySend{1000, 1000, false});
+      test.execute(DelayUs{1000, 7000});
+    }
+
+    {
+      PacerTestHarness test{"zero rate is unlimited"};
+
+      test.execute(SetRate{0, 0, 0});
+      for (int i = 0; i < 100; i++) {
+        test.execute(TrySend{0, 1500, true});
+      }
+      test.execute(DelayUs{1500, 0});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      TransceiverTestHarness test{"pacing rate follows cwnd / srtt", cfg};
+
+      // 尚无 RTT 样本时不限速
+      test.execute(PacingRate{0});
+      test.execute(PacingBurst{0});
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Tick{10});
+      test.execute(ReceiveAck{1, 60000});
+
+      // 慢启动：每 10 ms 发出两倍的拥塞窗口
+      test.execute(Cwnd{10001});
+      test.execute(PacingRate{2000200});
+      test.execute(PacingBurst{2000});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.max_pacing_rate = 500000;
+      TransceiverTestHarness test{"configured cap limits the pacing rate",
+                                  cfg};
+
+      test.execute(PacingRate{500000});
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Tick{10});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(PacingRate{500000});
+      test.execute(PacingBurst{2000});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.pacing = false;
+      cfg.max_pacing_rate = 500000;
+      TransceiverTestHarness test{"pacing can be disabled", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Tick{10});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(PacingRate{0});
+      test.execute(PacingBurst{0});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
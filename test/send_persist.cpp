@@ -0,0 +1,89 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "transceiver_test_harness.h"
+
+using namespace std;
+
+int main() {
+  try {
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.timestamps = false;
+      TransceiverTestHarness test{"zero window is probed with backoff", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Tick{100});
+      test.execute(ReceiveAck{1, 1000});
+      test.execute(Rto{300});
+
+      test.execute(PushData{string(1000, 'x')});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(Tick{100});
+      test.execute(ReceiveAck{1001, 0});
+      test.execute(Rto{250});
+
+      // 窗口关闭后新数据不再发送，由持续计时器探测
+      test.execute(PushData{"abc"});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{249});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{1});
+      test.execute(ExpectSegment{1000, 0});
+      test.execute(WindowProbes{1});
+      test.execute(SeqnosInFlight{0});
+
+      // 窗口仍为零，下一次探测的间隔加倍
+      test.execute(ReceiveAck{1001, 0});
+      test.execute(Tick{250});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{250});
+      test.execute(ExpectSegment{1000, 0});
+      test.execute(WindowProbes{2});
+
+      // 窗口打开后立即发送，计时器停止
+      test.execute(ReceiveAck{1001, 1000});
+      test.execute(ExpectSegment{1001, 3});
+      test.execute(ReceiveAck{1004, 1000});
+      test.execute(Tick{10000});
+      test.execute(ExpectNoSegment{});
+      test.execute(WindowProbes{2});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.nodelay = true;
+      TransceiverTestHarness test{"sender avoids silly windows", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveAck{1, 4000});
+
+      test.execute(PushData{string(4000, 'x')});
+      for (uint64_t seqno = 1; seqno < 4001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+
+      // 窗口右边界前进 1500 字节：发出一个完整的报文，
+      // 剩下的 500 字节不到最大窗口的一半，等下一个 ACK
+      test.execute(ReceiveAck{2001, 3500});
+      test.execute(PushData{string(3000, 'x')});
+      test.execute(ExpectSegment{4001, 1000});
+      test.execute(ExpectNoSegment{});
+
+      test.execute(ReceiveAck{5001, 4000});
+      test.execute(ExpectSegment{5001, 1000});
+      test.execute(ExpectSegment{6001, 1000});
+      test.execute(ExpectNoSegment{});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
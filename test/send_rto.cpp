@@ -0,0 +1,133 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "transceiver_test_harness.h"
+
+using namespace std;
+
+int main() {
+  try {
+    const string data(1000, 'x');
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      TransceiverTestHarness test{"RTO follows SRTT and RTTVAR", cfg};
+
+      // 没有 RTT 样本时使用 rt_timeout
+      test.execute(TimerArmed{false});
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(NextTimeout{1000});
+      test.execute(Tick{999});
+      test.execute(NextTimeout{1});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{1});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Rto{2000});
+
+      // Karn: 重传过的 SYN 不产生样本
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(Rto{1000});
+      test.execute(TimerArmed{false});
+
+      // 第一个样本：SRTT = 40, RTTVAR = 20
+      test.execute(PushData{data});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(Tick{40});
+      test.execute(ReceiveAck{1001, 60000});
+      test.execute(Rto{120});
+
+      // RTTVAR = 3/4 * 20 + 1/4 * 0 = 15
+      test.execute(PushData{data});
+      test.execute(ExpectSegment{1001, 1000});
+      test.execute(Tick{40});
+      test.execute(ReceiveAck{2001, 60000});
+      test.execute(Rto{100});
+
+      // 超时后指数退避
+      test.execute(PushData{data});
+      test.execute(ExpectSegment{2001, 1000});
+      test.execute(Tick{99});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{1});
+      test.execute(ExpectSegment{2001, 1000});
+      test.execute(Rto{200});
+      test.execute(Tick{199});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{1});
+      test.execute(ExpectSegment{2001, 1000});
+      test.execute(Rto{400});
+
+      // 新的确认取消退避，重传的报文不更新估计
+      test.execute(ReceiveAck{3001, 60000});
+      test.execute(Rto{100});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.min_rto = 200;
+      cfg.max_rto = 300;
+      TransceiverTestHarness test{"RTO is clamped to the configured range",
+                                  cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Tick{10});
+      test.execute(ReceiveAck{1, 60000});
+      test.execute(Rto{200});
+
+      test.execute(PushData{data});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(Tick{200});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(Rto{300});
+      test.execute(Tick{300});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(Rto{300});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      TransceiverTestHarness test{"tail loss probe precedes the RTO", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Tick{20});
+      test.execute(ReceiveAck{1, 60000});
+
+      test.execute(PushData{string(4000, 'x')});
+      for (uint64_t seqno = 1; seqno < 4001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+
+      // 最后两个报文丢失：SRTT = 20，探测超时 40 ms 早于 RTO (50 ms)
+      test.execute(Tick{20});
+      test.execute(ReceiveAck{2001, 60000});
+      test.execute(Rto{50});
+      test.execute(NextTimeout{40});
+      test.execute(Tick{39});
+      test.execute(NextTimeout{1});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{1});
+      test.execute(ExpectSegment{3001, 1000});
+      test.execute(ExpectNoSegment{});
+
+      // 探测报文的 SACK 让 RACK 发现 2001 丢失
+      test.execute(Tick{20});
+      test.execute(ReceiveAck{2001, 60000}.with_sack(3001, 4001));
+      test.execute(ExpectSegment{2001, 1000});
+      test.execute(ExpectNoSegment{});
+      test.execute(ReceiveAck{4001, 60000});
+      test.execute(SeqnosInFlight{0});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "transceiver_test_harness.h"
+
+using namespace std;
+
+int main() {
+  try {
+    const string data(6000, 'x');
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      TransceiverTestHarness test{"SACK infers losses and repairs holes", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveAck{1, 10000});
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 6001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+      test.execute(ExpectNoSegment{});
+
+      // 1 和 2001 丢失，其余到达
+      test.execute(ReceiveAck{1, 10000}.with_sack(1001, 2001));
+      test.execute(ReceiveAck{1, 10000}.with_sack(3001, 4001).with_sack(
+          1001, 2001));
+      test.execute(ExpectNoSegment{});
+      test.execute(InRecovery{false});
+
+      test.execute(ReceiveAck{1, 10000}.with_sack(3001, 5001).with_sack(
+          1001, 2001));
+      test.execute(InRecovery{true});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(ExpectNoSegment{});
+
+      test.execute(ReceiveAck{1, 10000}.with_sack(3001, 6001).with_sack(
+          1001, 2001));
+      test.execute(ExpectSegment{2001, 1000});
+      test.execute(ExpectNoSegment{});
+
+      test.execute(ReceiveAck{2001, 10000}.with_sack(3001, 6001));
+      test.execute(ExpectNoSegment{});
+      test.execute(ReceiveAck{6001, 10000});
+      test.execute(InRecovery{false});
+      test.execute(SeqnosInFlight{0});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      cfg.rt_timeout = 100;
+      cfg.congestion_control = CongestionAlgorithm::NewReno;
+      // RACK 的乱序计时器会先于超时修复空洞，这里只检查超时
+      cfg.rack = false;
+      TransceiverTestHarness test{"RTO repairs holes at the slow-start rate",
+                                  cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(ReceiveAck{1, 10000});
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 6001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+
+      // 只有 3001 到达
+      test.execute(ReceiveAck{1, 10000}.with_sack(3001, 4001));
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{100});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(ExpectNoSegment{});
+      test.execute(Cwnd{1000});
+
+      // 每个 ACK 都继续修复空洞，而不是每次超时只重传一个报文
+      test.execute(ReceiveAck{1001, 10000}.with_sack(3001, 4001));
+      test.execute(ExpectSegment{1001, 1000});
+      test.execute(ExpectSegment{2001, 1000});
+      test.execute(ExpectNoSegment{});
+
+      test.execute(ReceiveAck{4001, 10000});
+      test.execute(ExpectSegment{4001, 1000});
+      test.execute(ExpectSegment{5001, 1000});
+      test.execute(ExpectNoSegment{});
+    }
+
+    {
+      TCPConfig cfg;
+      cfg.mss = 1000;
+      TransceiverTestHarness test{"RACK marks losses by time", cfg};
+
+      test.execute(PushData{});
+      test.execute(ExpectSegment{0, 0}.with_syn());
+      test.execute(Tick{20});
+      test.execute(ReceiveAck{1, 10000});
+      test.execute(PushData{data});
+      for (uint64_t seqno = 1; seqno < 6001; seqno += 1000) {
+        test.execute(ExpectSegment{seqno, 1000});
+      }
+
+      // 只有一个 SACK 块，不满足重复阈值；
+      // 同时发送的 1 在 RTT 加乱序窗口 (10 ms) 后仍未到达则认为丢失
+      test.execute(Tick{20});
+      test.execute(ReceiveAck{1, 10000}.with_sack(1001, 2001));
+      test.execute(InRecovery{false});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{9});
+      test.execute(ExpectNoSegment{});
+      test.execute(Tick{1});
+      test.execute(InRecovery{true});
+      test.execute(ExpectSegment{1, 1000});
+      test.execute(ExpectNoSegment{});
+    }
+
+    {
+      TCPConfig cfg;
+      TransceiverTestHarness test{"receiver reports out-of-order data", cfg};
+
+      test.execute(ReceiveSegment{0, ""}.with_syn(true));
+      test.execute(ExpectSackBlocks{{}});
+      test.execute(ReceiveSegment{1, "abcd"});
+      test.execute(ReceiveSegment{9, "ijkl"});
+      test.execute(ExpectSackBlocks{{{9, 13}}});
+      test.execute(ReceiveSegment{17, "qrst"});
+      test.execute(ExpectSackBlocks{{{17, 21}, {9, 13}}});
+      test.execute(ReceiveSegment{13, "mnop"});
+      test.execute(ExpectSackBlocks{{{9, 21}}});
+      test.execute(ReceiveSegment{5, "efgh"});
+      test.execute(ExpectSackBlocks{{}});
+    }
+
+    {
+      TCPConfig cfg;
+      TransceiverTestHarness test{"no SACK unless the peer permits it", cfg};
+
+      test.execute(ReceiveSegment{0, ""}.with_syn(false));
+      test.execute(ReceiveSegment{9, "ijkl"});
+      test.execute(ExpectSackBlocks{{}});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
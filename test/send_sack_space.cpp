@@ -0,0 +1,78 @@
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "endpoint_test_harness.h"
+
+using namespace std;
+
+//! 对端允许 SACK，没有通告 MSS (按 536 字节)，也不使用时间戳
+static void handshake(EndpointTestHarness& test) {
+  test.execute(PeerSends{0, ""}.with_syn().with_sack_permitted());
+  test.execute(ExpectAck{1});
+  test.execute(PeerSends{1, ""});
+}
+
+//! 载荷与选项合计不超过 MSS：TCP 报文不超过 20 + 536 字节
+static constexpr size_t MAX_LENGTH = 20 + 536;
+
+int main() {
+  try {
+    {
+      TCPConfig cfg;
+      cfg.nodelay = true;
+      EndpointTestHarness test{"payload leaves room for pending SACK blocks",
+                               cfg};
+      handshake(test);
+
+      test.execute(PeerSends{1001, string(100, 'x')});
+      test.execute(ExpectAck{1}.with_sack_blocks(1));
+
+      // 一个 SACK 块占用 12 字节
+      test.execute(AppWrites{string(1000, 'y')});
+      test.execute(ExpectAck{1}
+                       .with_payload_size(524)
+                       .with_sack_blocks(1)
+                       .with_max_length(MAX_LENGTH));
+      test.execute(ExpectAck{1}
+                       .with_payload_size(476)
+                       .with_sack_blocks(1)
+                       .with_max_length(MAX_LENGTH));
+      test.execute(ExpectNothing{});
+
+      // 空洞填上后恢复完整的载荷
+      test.execute(PeerSends{1, string(1000, 'x')});
+      test.execute(ExpectAck{1101}.with_sack_blocks(0));
+      test.execute(AppWrites{string(536, 'y')});
+      test.execute(ExpectAck{1101}
+                       .with_payload_size(536)
+                       .with_max_length(MAX_LENGTH));
+    }
+
+    {
+      TCPConfig cfg;
+      EndpointTestHarness test{"segments cut before SACK blocks appear", cfg};
+      handshake(test);
+
+      test.execute(AppWrites{string(1072, 'y')});
+      test.execute(PeerSends{1001, string(100, 'x')});
+
+      // 已分好的满载报文放不下 SACK 块，由随后的 ACK 携带
+      test.execute(ExpectAck{1}
+                       .with_payload_size(536)
+                       .with_sack_blocks(0)
+                       .with_max_length(MAX_LENGTH));
+      test.execute(ExpectAck{1}
+                       .with_payload_size(536)
+                       .with_sack_blocks(0)
+                       .with_max_length(MAX_LENGTH));
+      test.execute(ExpectAck{1}.with_sack_blocks(1));
+      test.execute(ExpectNothing{});
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
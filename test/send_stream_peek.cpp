@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "buffer/stream_buffer.h"
+#include "common.h"
+
+using namespace std;
+
+static void expect(const bool condition, const string& what) {
+  if (!condition) {
+    throw ExpectationViolation(what);
+  }
+}
+
+//! 第 i 个字节的内容，用来检查查看到的位置
+static char byte_at(const uint64_t i) {
+  return static_cast<char>('a' + i % 26);
+}
+
+static string bytes(const uint64_t begin, const uint64_t len) {
+  string out;
+  for (uint64_t i = begin; i < begin + len; i++) {
+    out += byte_at(i);
+  }
+  return out;
+}
+
+int main() {
+  try {
+    {
+      // 小的写入合并成一个块，跨越多次写入的范围不需要拼接
+      StreamBuffer stream{100000};
+      for (uint64_t i = 0; i < 3000; i += 10) {
+        stream.writer().push(bytes(i, 10));
+      }
+      const Buffer slice = stream.reader().peek(5, 1460);
+      expect(string_view{slice} == bytes(5, 1460),
+             "a peek should return the bytes at the offset");
+      expect(string_view{slice}.data() == stream.reader().peek().data() + 5,
+             "a peek across small writes should share the merged chunk");
+      expect(stream.reader().peek().size() == 3000,
+             "the front view should cover the whole merged chunk");
+
+      // 合并块写满后另起一块，其中的切片不受之后追加的影响
+      const Buffer head = stream.reader().peek(0, 3000);
+      for (uint64_t i = 3000; i < 20000; i += 10) {
+        stream.writer().push(bytes(i, 10));
+      }
+      expect(string_view{head} == bytes(0, 3000),
+             "appending should not change an earlier slice");
+      const uint64_t front = stream.reader().peek().size();
+      expect(front + 10 > StreamBuffer::MERGED_CHUNK and front < 20000,
+             "a merged chunk should be filled up to its capacity");
+      expect(string_view{stream.reader().peek(16000, 1000)} ==
+                 bytes(16000, 1000),
+             "a peek spanning two merged chunks should be joined");
+    }
+
+    {
+      // 游标随查看向后移动，pop 之后与向前查看时仍然正确
+      StreamBuffer stream{100000};
+      for (uint64_t i = 0; i < 40000; i += 4000) {
+        stream.writer().push(bytes(i, 4000));
+      }
+      for (uint64_t offset = 0; offset < 40000; offset += 1460) {
+        expect(string_view{stream.reader().peek(offset, 1460)} ==
+                   bytes(offset, min<uint64_t>(1460, 40000 - offset)),
+               "sequential peeks should follow the stream");
+      }
+      expect(string_view{stream.reader().peek(100, 50)} == bytes(100, 50),
+             "a peek behind the cursor should restart from the front");
+
+      stream.reader().pop(9000);
+      expect(string_view{stream.reader().peek(0, 100)} == bytes(9000, 100),
+             "offsets should be relative to the bytes popped");
+      expect(string_view{stream.reader().peek(20000, 1460)} ==
+                 bytes(29000, 1460),
+             "a peek after a pop should find its chunk");
+      stream.reader().pop(11000);
+      expect(string_view{stream.reader().peek(9000, 2000)} ==
+                 bytes(29000, 2000),
+             "the cursor should follow chunks that were popped");
+      expect(string_view{stream.reader().peek(19000, 5000)} ==
+                 bytes(39000, 1000),
+             "a peek should stop at the end of the stream");
+      expect(stream.reader().peek(20000, 10).empty(),
+             "a peek past the end should be empty");
+
+      stream.reader().pop(20000);
+      stream.writer().push(bytes(40000, 10));
+      expect(string_view{stream.reader().peek(0, 10)} == bytes(40000, 10),
+             "a peek after draining the stream should see new data");
+    }
+
+    {
+      // 复制出的缓冲区共享合并块，各自的写入互不影响
+      StreamBuffer stream{100000};
+      stream.writer().push(string{"abc"});
+      StreamBuffer copy = stream;
+      stream.writer().push(string{"def"});
+      copy.writer().push(string{"xyz"});
+      expect(string_view{stream.reader().peek(0, 6)} == "abcdef",
+             "the original should keep its own writes");
+      expect(string_view{copy.reader().peek(0, 6)} == "abcxyz",
+             "the copy should keep its own writes");
+    }
+
+    {
+      // 部分 pop 之后追加的数据接在队首视图之后
+      StreamBuffer stream{100000};
+      stream.writer().push(string{"hello "});
+      stream.reader().pop(2);
+      stream.writer().push(string{"world"});
+      expect(stream.reader().peek() == "llo world",
+             "the front view should keep the bytes already popped");
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
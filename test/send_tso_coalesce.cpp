@@ -0,0 +1,193 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "tun/tun_adapter.h"
+
+using namespace std;
+
+static void expect(const bool condition, const string& what) {
+  if (!condition) {
+    throw ExpectationViolation(what);
+  }
+}
+
+static const Wrap32 ISN{1000};
+static constexpr size_t MSS = 1000;
+
+//! 依次发出的报文：每个接在上一个之后，带有相同的 ACK
+class Segments {
+  vector<TCPSegment> segs_{};
+  uint64_t next_{1};
+
+ public:
+  TCPSegment& add(const size_t size) {
+    TCPSegment seg;
+    seg.sender_message = {.seqno = ISN + next_, .payload = string(size, 'x')};
+    seg.receiver_message = {.ackno = Wrap32{5000}, .window_size = 60000};
+    next_ += size;
+    return segs_.emplace_back(std::move(seg));
+  }
+
+  vector<TCPSegment>& segs() { return segs_; }
+};
+
+//! 按 coalesce_run 划分出的各个超级报文的长度
+static vector<size_t> runs(const vector<TCPSegment>& segs) {
+  vector<size_t> lengths;
+  for (size_t i = 0; i < segs.size();) {
+    const size_t end = coalesce_run(segs, i);
+    lengths.push_back(end - i);
+    i = end;
+  }
+  return lengths;
+}
+
+int main() {
+  try {
+    {
+      // 满 MSS 的报文合并，最后一个可以更短
+      Segments s;
+      for (int i = 0; i < 4; i++) {
+        s.add(MSS);
+      }
+      s.add(300);
+      expect(runs(s.segs()) == vector<size_t>{5},
+             "full segments and a short tail should form one run");
+
+      const VirtioNetHeader vnet = offload_header(s.segs());
+      expect(vnet.gso_type == VirtioNetHeader::GSO_TCPV4,
+             "a run should be sent as TCPv4 GSO");
+      expect(vnet.gso_size == MSS,
+             "gso_size should be the first payload size");
+      expect(vnet.hdr_len ==
+                 IPv4Header::LENGTH + s.segs().front().header_length(),
+             "hdr_len should cover the IP and TCP headers");
+      expect(vnet.flags == VirtioNetHeader::F_NEEDS_CSUM and
+                 vnet.csum_start == IPv4Header::LENGTH and
+                 vnet.csum_offset == 16,
+             "the kernel should complete the TCP checksum");
+    }
+
+    {
+      // 单个报文只卸载校验和
+      Segments s;
+      s.add(MSS);
+      const VirtioNetHeader vnet = offload_header(s.segs());
+      expect(vnet.gso_type == VirtioNetHeader::GSO_NONE and
+                 vnet.gso_size == 0 and vnet.hdr_len == 0,
+             "a single segment should not use GSO");
+      expect(vnet.flags == VirtioNetHeader::F_NEEDS_CSUM,
+             "a single segment should still offload the checksum");
+    }
+
+    {
+      // 短报文之后不能再接报文，否则内核切分的边界与原报文不同
+      Segments s;
+      s.add(MSS);
+      s.add(500);
+      s.add(MSS);
+      s.add(MSS);
+      expect(runs(s.segs()) == vector<size_t>{2, 2},
+             "only the last segment of a run may be shorter");
+      expect(offload_header(span{s.segs()}.subspan(2)).gso_size == MSS,
+             "the next run should start with its own gso_size");
+    }
+
+    {
+      // 比第一个报文长的报文不能接在之后
+      Segments s;
+      s.add(500);
+      s.add(MSS);
+      expect(runs(s.segs()) == vector<size_t>{1, 1},
+             "a longer segment should not follow a shorter one");
+    }
+
+    {
+      // FIN 只能在最后一个报文上
+      Segments s;
+      s.add(MSS);
+      s.add(MSS).sender_message.FIN = true;
+      s.add(MSS);
+      expect(runs(s.segs()) == vector<size_t>{2, 1},
+             "coalescing should stop after a FIN");
+    }
+
+    {
+      // SYN 不合并
+      Segments s;
+      s.add(MSS).sender_message.SYN = true;
+      TCPSenderMessage& next = s.add(MSS).sender_message;
+      next.seqno = next.seqno + 1;  // 接在 SYN 占用的序号之后
+      expect(runs(s.segs()) == vector<size_t>{1, 1},
+             "a SYN should not start a run");
+
+      Segments t;
+      t.add(MSS);
+      t.add(MSS).sender_message.SYN = true;
+      expect(runs(t.segs()) == vector<size_t>{1, 1},
+             "a SYN should not join a run");
+    }
+
+    {
+      // 切分后每段复制第一个报文的时间戳，TSval 不同时不能合并
+      Segments s;
+      s.add(MSS).sender_message.ts_val = 10;
+      s.add(MSS).sender_message.ts_val = 10;
+      s.add(MSS).sender_message.ts_val = 11;
+      expect(runs(s.segs()) == vector<size_t>{2, 1},
+             "coalescing should stop when TSval changes");
+
+      Segments t;
+      t.add(MSS).receiver_message.ts_ecr = 7;
+      t.add(MSS).receiver_message.ts_ecr = 8;
+      expect(runs(t.segs()) == vector<size_t>{1, 1},
+             "coalescing should stop when TSecr changes");
+    }
+
+    {
+      // SACK 块不同的报文不能合并
+      Segments s;
+      s.add(MSS);
+      const vector<TCPSackBlock> sack{{Wrap32{6000}, Wrap32{7000}}};
+      s.add(MSS).receiver_message.sack_blocks = sack;
+      s.add(MSS).receiver_message.sack_blocks = sack;
+      expect(runs(s.segs()) == vector<size_t>{1, 2},
+             "coalescing should stop when SACK blocks change");
+    }
+
+    {
+      // 序号不连续 (如重传) 或 ACK 不同时不能合并
+      Segments s;
+      s.add(MSS);
+      s.add(MSS).sender_message.seqno = ISN + 1;
+      expect(runs(s.segs()) == vector<size_t>{1, 1},
+             "coalescing should need contiguous seqnos");
+
+      Segments t;
+      t.add(MSS);
+      t.add(MSS).receiver_message.ackno = Wrap32{6000};
+      expect(runs(t.segs()) == vector<size_t>{1, 1},
+             "coalescing should need the same ACK");
+    }
+
+    {
+      // 超级报文不超过 IPv4 数据报的最大长度
+      Segments s;
+      for (int i = 0; i < 70; i++) {
+        s.add(MSS);
+      }
+      const auto lengths = runs(s.segs());
+      expect(lengths.size() == 2 and lengths.front() == 65,
+             "a run should fit in one IPv4 datagram");
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
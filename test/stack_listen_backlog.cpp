@@ -0,0 +1,89 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <exception>
+#include <future>
+#include <iostream>
+#include <string>
+
+#include "common.h"
+#include "connect/tcp_stack.h"
+#include "utils/exception.h"
+
+using namespace std;
+
+static void expect(const bool condition, const string& what) {
+  if (!condition) {
+    throw ExpectationViolation(what);
+  }
+}
+
+//! 握手完成、等待 accept() 的一条连接 (socketpair 的一端)
+static TCPStackSocket established_socket() {
+  array<int, 2> fds{};
+  CheckSystemCall("socketpair",
+                  ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()));
+  ::close(fds[1]);  // 不需要另一端
+  promise<void> closed;
+  return {Socket(FileDescriptor(fds[0]), AF_UNIX, SOCK_STREAM),
+          closed.get_future().share()};
+}
+
+int main() {
+  try {
+    {
+      // 半连接队列已满时丢弃 SYN
+      ListenQueue queue{TCPConfig{}, 0, 2};
+      expect(queue.admit_syn() and queue.admit_syn(),
+             "SYNs should be admitted below the backlog");
+      expect(queue.syn_received == 2, "each SYN should take a slot");
+      expect(!queue.admit_syn(), "a SYN should be dropped at the backlog");
+      expect(queue.syn_received == 2 and queue.syns_dropped == 1,
+             "a dropped SYN should not take a slot");
+
+      // 握手完成或失败后腾出位置
+      queue.syn_received -= 1;
+      expect(queue.admit_syn(), "a freed slot should admit a SYN");
+      expect(queue.syns_dropped == 1, "no SYN should be dropped");
+    }
+
+    {
+      // 全连接队列已满时，即使半连接队列有空位也丢弃
+      ListenQueue queue{TCPConfig{}, 0, 2};
+      queue.established.push_back(established_socket());
+      expect(!queue.accept_queue_full(), "one connection should fit");
+      queue.established.push_back(established_socket());
+      expect(queue.accept_queue_full(), "the accept queue should be full");
+      expect(!queue.admit_syn(), "a SYN should be dropped when full");
+      expect(queue.syn_received == 0 and queue.syns_dropped == 1,
+             "the dropped SYN should not take a slot");
+
+      queue.established.pop_front();
+      expect(queue.admit_syn(), "accept() should make room again");
+    }
+
+    {
+      // 使用 SYN cookie 时没有半连接队列，只受全连接队列限制
+      TCPConfig cfg;
+      cfg.syn_cookies = true;
+      ListenQueue queue{cfg, 0, 2};
+      queue.cookies.emplace(cfg);
+      for (int i = 0; i < 100; i++) {
+        expect(queue.admit_syn(), "cookies should admit every SYN");
+      }
+      expect(queue.syn_received == 0 and queue.syns_dropped == 0,
+             "cookies should not use the SYN queue");
+
+      queue.established.push_back(established_socket());
+      queue.established.push_back(established_socket());
+      expect(!queue.admit_syn() and queue.syns_dropped == 1,
+             "cookies should still respect the accept queue");
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "connect/tcp_stack.h"
+
+using namespace std;
+
+static void expect(const bool condition, const string& what) {
+  if (!condition) {
+    throw ExpectationViolation(what);
+  }
+}
+
+//! 各分片分到的四元组数都在平均值的 ±10% 以内
+static void expect_balanced(const vector<FourTuple>& tuples,
+                            const size_t shards, const string& what) {
+  vector<size_t> counts(shards);
+  for (const auto& tuple : tuples) {
+    const size_t index = TCPStack::shard_index(tuple, shards);
+    expect(index < shards, what + ": shard index out of range");
+    expect(index == TCPStack::shard_index(tuple, shards),
+           what + ": shard index should be stable");
+    counts[index]++;
+  }
+  const size_t mean = tuples.size() / shards;
+  for (size_t i = 0; i < shards; i++) {
+    expect(counts[i] * 10 >= mean * 9 and counts[i] * 10 <= mean * 11,
+           what + ": shard " + to_string(i) + " of " + to_string(shards) +
+               " got " + to_string(counts[i]) + ", expected about " +
+               to_string(mean));
+  }
+}
+
+int main() {
+  try {
+    constexpr uint32_t LOCAL = 0xa9fe9009;
+    constexpr uint32_t REMOTE = 0xa9fe9001;
+    constexpr size_t COUNT = 48000;
+
+    // 一个客户端的许多源端口 (连接到栈的监听端口)
+    vector<FourTuple> ports;
+    for (size_t i = 0; i < COUNT; i++) {
+      ports.push_back({.local_address = LOCAL,
+                       .local_port = 9000,
+                       .remote_address = REMOTE,
+                       .remote_port = static_cast<uint16_t>(10000 + i)});
+    }
+
+    // 许多客户端使用同一个源端口
+    vector<FourTuple> addresses;
+    for (size_t i = 0; i < COUNT; i++) {
+      addresses.push_back({.local_address = LOCAL,
+                           .local_port = 9000,
+                           .remote_address = static_cast<uint32_t>(
+                               0x0a000000 + i),
+                           .remote_port = 40000});
+    }
+
+    // 栈主动打开：本端端口变化，对端固定
+    vector<FourTuple> active;
+    for (size_t i = 0; i < COUNT; i++) {
+      active.push_back({.local_address = LOCAL,
+                        .local_port = static_cast<uint16_t>(20000 + i),
+                        .remote_address = REMOTE,
+                        .remote_port = 80});
+    }
+
+    for (const size_t shards : {1, 2, 3, 4, 8}) {
+      expect_balanced(ports, shards, "remote ports");
+      expect_balanced(addresses, shards, "remote addresses");
+      expect_balanced(active, shards, "local ports");
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
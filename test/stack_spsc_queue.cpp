@@ -0,0 +1,87 @@
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "common.h"
+#include "utils/spsc_queue.h"
+
+using namespace std;
+
+static void expect(const bool condition, const string& what) {
+  if (!condition) {
+    throw ExpectationViolation(what);
+  }
+}
+
+int main() {
+  try {
+    {
+      SpscQueue<string> queue{4};
+      expect(!queue.pop().has_value(), "a new queue should be empty");
+
+      for (int i = 0; i < 4; i++) {
+        expect(queue.push(to_string(i)), "push should succeed until full");
+      }
+      // 已满时 push 失败，元素留在调用方
+      string extra = "extra";
+      expect(!queue.push(std::move(extra)), "push to a full queue should fail");
+      expect(extra == "extra", "a rejected element should not be moved");
+
+      for (int i = 0; i < 4; i++) {
+        const auto value = queue.pop();
+        expect(value == to_string(i), "pop should return elements in order");
+      }
+      expect(!queue.pop().has_value(), "a drained queue should be empty");
+    }
+
+    {
+      // 下标越过容量后回绕，顺序和满/空的判断不变
+      SpscQueue<int> queue{3};
+      int next_push = 0;
+      int next_pop = 0;
+      for (int round = 0; round < 10; round++) {
+        while (queue.push(int{next_push})) {
+          next_push++;
+        }
+        expect(next_push - next_pop == 3,
+               "the queue should hold exactly its capacity");
+        for (int i = 0; i < 2; i++) {
+          expect(queue.pop() == next_pop++,
+                 "pop should keep the order across wraparound");
+        }
+      }
+      while (auto value = queue.pop()) {
+        expect(value == next_pop++, "pop should drain the remaining ones");
+      }
+      expect(next_pop == next_push, "every pushed element should be popped");
+    }
+
+    {
+      // 生产者与消费者在不同线程
+      constexpr uint64_t COUNT = 100000;
+      SpscQueue<uint64_t> queue{64};
+      thread producer([&] {
+        for (uint64_t i = 0; i < COUNT;) {
+          if (queue.push(uint64_t{i})) {
+            i++;
+          }
+        }
+      });
+      uint64_t expected = 0;
+      while (expected < COUNT) {
+        if (const auto value = queue.pop()) {
+          expect(value == expected++, "elements should arrive in order");
+        }
+      }
+      producer.join();
+      expect(!queue.pop().has_value(), "nothing should be left over");
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,467 @@
+#pragma once
+
+#include <optional>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+#include "config/tcp_config.h"
+#include "connect/reassembler.h"
+#include "connect/transceiver.h"
+#include "utils/parser.h"
+
+/**
+ * @brief 被测试的收发器，以及它读写的字节流
+ * 测试中的序列号均为绝对序列号，由 isn 换算为 Wrap32
+ */
+struct TransceiverAndStream {
+  Wrap32 isn;
+  Transceiver transceiver;
+  StreamBuffer outbound;
+  StreamBuffer inbound;
+  Reassembler reassembler{};
+};
+
+class TransceiverTestHarness : public TestHarness<TransceiverAndStream> {
+ public:
+  TransceiverTestHarness(std::string test_name, TCPConfig config)
+      : TestHarness(std::move(test_name),
+                    "rt_timeout=" + std::to_string(config.rt_timeout),
+                    make_object(config)) {}
+
+ private:
+  static TransceiverAndStream make_object(TCPConfig& config) {
+    if (!config.fixed_isn) {
+      config.fixed_isn = Wrap32{0x8000'0000};
+    }
+    return {config.fixed_isn.value(), Transceiver{config},
+            StreamBuffer{config.send_capacity},
+            StreamBuffer{config.recv_capacity}};
+  }
+};
+
+/* actions */
+
+struct PushData : public Action<TransceiverAndStream> {
+  std::string data_;
+  bool close_{};
+
+  explicit PushData(std::string data = {}) : data_(std::move(data)) {}
+
+  PushData& with_close(bool close = true) {
+    close_ = close;
+    return *this;
+  }
+
+  std::string description() const override {
+    return "push " + std::to_string(data_.size()) + " bytes" +
+           (close_ ? " and close" : "");
+  }
+
+  void execute(TransceiverAndStream& ts) const override {
+    ts.outbound.writer().push(data_);
+    if (close_) {
+      ts.outbound.writer().close();
+    }
+    ts.transceiver.push(ts.outbound.reader());
+  }
+};
+
+struct Tick : public Action<TransceiverAndStream> {
+  uint64_t ms_;
+
+  explicit Tick(uint64_t ms) : ms_(ms) {}
+  std::string description() const override {
+    return "tick " + std::to_string(ms_) + " ms";
+  }
+  void execute(TransceiverAndStream& ts) const override {
+    ts.transceiver.tick(ms_);
+  }
+};
+
+struct SetCork : public Action<TransceiverAndStream> {
+  bool cork_;
+
+  explicit SetCork(bool cork) : cork_(cork) {}
+  std::string description() const override {
+    return cork_ ? "cork" : "uncork";
+  }
+  void execute(TransceiverAndStream& ts) const override {
+    ts.transceiver.set_cork(cork_);
+    ts.transceiver.push(ts.outbound.reader());
+  }
+};
+
+struct ReceiveAck : public Action<TransceiverAndStream> {
+  uint64_t ackno_;
+  uint16_t window_size_;
+  std::vector<std::pair<uint64_t, uint64_t>> sack_{};
+  std::optional<uint32_t> ts_ecr_{};
+
+  ReceiveAck(uint64_t ackno, uint16_t window_size)
+      : ackno_(ackno), window_size_(window_size) {}
+
+  ReceiveAck& with_ts_ecr(uint32_t ts_ecr) {
+    ts_ecr_ = ts_ecr;
+    return *this;
+  }
+
+  ReceiveAck& with_sack(uint64_t left, uint64_t right) {
+    sack_.emplace_back(left, right);
+    return *this;
+  }
+
+  std::string description() const override {
+    std::ostringstream ss;
+    ss << "receive ack " << ackno_ << " window " << window_size_;
+    for (const auto& [left, right] : sack_) {
+      ss << " sack [" << left << ", " << right << ")";
+    }
+    return ss.str();
+  }
+
+  void execute(TransceiverAndStream& ts) const override {
+    TCPReceiverMessage msg{.ackno = ts.isn + ackno_,
+                           .window_size = window_size_,
+                           .ts_ecr = ts_ecr_};
+    for (const auto& [left, right] : sack_) {
+      msg.sack_blocks.push_back({ts.isn + left, ts.isn + right});
+    }
+    ts.transceiver.receive_ack(msg);
+    ts.transceiver.push(ts.outbound.reader());
+  }
+};
+
+struct ReceiveSegment : public Action<TransceiverAndStream> {
+  uint64_t seqno_;
+  std::string payload_;
+  bool syn_{};
+  bool sack_permitted_{};
+  std::optional<uint16_t> mss_{};
+  std::optional<uint8_t> window_scale_{};
+  std::optional<uint32_t> ts_val_{};
+
+  ReceiveSegment(uint64_t seqno, std::string payload)
+      : seqno_(seqno), payload_(std::move(payload)) {}
+
+  ReceiveSegment& with_syn(bool sack_permitted) {
+    syn_ = true;
+    sack_permitted_ = sack_permitted;
+    return *this;
+  }
+
+  ReceiveSegment& with_mss(uint16_t mss) {
+    mss_ = mss;
+    return *this;
+  }
+
+  ReceiveSegment& with_window_scale(uint8_t shift) {
+    window_scale_ = shift;
+    return *this;
+  }
+
+  ReceiveSegment& with_ts_val(uint32_t ts_val) {
+    ts_val_ = ts_val;
+    return *this;
+  }
+
+  std::string description() const override {
+    return "receive segment @ " + std::to_string(seqno_) + " with " +
+           std::to_string(payload_.size()) + " bytes" +
+           (syn_ ? " [SYN]" : "");
+  }
+
+  void execute(TransceiverAndStream& ts) const override {
+    TCPSenderMessage msg{.seqno = ts.isn + seqno_,
+                         .SYN = syn_,
+                         .payload = {payload_},
+                         .mss = mss_,
+                         .sack_permitted = sack_permitted_,
+                         .window_scale = window_scale_,
+                         .ts_val = ts_val_};
+    ts.transceiver.receive_isn(std::move(msg), ts.reassembler,
+                               ts.inbound.writer());
+  }
+};
+
+/* expectations */
+
+struct ExpectSegment : public Expectation<TransceiverAndStream> {
+  uint64_t seqno_;
+  size_t payload_size_;
+  bool syn_{};
+  bool fin_{};
+  std::optional<uint16_t> mss_{};
+  std::optional<std::optional<uint8_t>> window_scale_{};
+  std::optional<std::optional<uint32_t>> ts_val_{};
+
+  ExpectSegment(uint64_t seqno, size_t payload_size)
+      : seqno_(seqno), payload_size_(payload_size) {}
+
+  ExpectSegment& with_syn(bool syn = true) {
+    syn_ = syn;
+    return *this;
+  }
+
+  ExpectSegment& with_fin(bool fin = true) {
+    fin_ = fin;
+    return *this;
+  }
+
+  //! 检查 SYN 中的 MSS 选项
+  ExpectSegment& with_mss(uint16_t mss) {
+    mss_ = mss;
+    return *this;
+  }
+
+  //! 检查 SYN 中的窗口扩大选项，std::nullopt 表示不应携带
+  ExpectSegment& with_window_scale(std::optional<uint8_t> shift) {
+    window_scale_ = shift;
+    return *this;
+  }
+
+  //! 检查时间戳选项中的 TSval，std::nullopt 表示不应携带
+  ExpectSegment& with_ts_val(std::optional<uint32_t> ts_val) {
+    ts_val_ = ts_val;
+    return *this;
+  }
+
+  std::string description() const override {
+    return "segment @ " + std::to_string(seqno_) + " with " +
+           std::to_string(payload_size_) + " bytes" + (syn_ ? " [SYN]" : "") +
+           (fin_ ? " [FIN]" : "");
+  }
+
+  void execute(TransceiverAndStream& ts) const override {
+    const auto msg = ts.transceiver.maybe_send();
+    if (!msg) {
+      throw ExpectationViolation{"expected a segment, but none was sent"};
+    }
+    if (!(msg->seqno == ts.isn + seqno_)) {
+      throw ExpectationViolation{"seqno", ts.isn + seqno_, msg->seqno};
+    }
+    if (msg->payload.size() != payload_size_) {
+      throw ExpectationViolation{"payload size", payload_size_,
+                                 msg->payload.size()};
+    }
+    if (msg->SYN != syn_) {
+      throw ExpectationViolation{"SYN", syn_, msg->SYN};
+    }
+    if (msg->FIN != fin_) {
+      throw ExpectationViolation{"FIN", fin_, msg->FIN};
+    }
+
+    // 选项经过一次序列化和解析后检查
+    TCPSegment seg{.sender_message = msg.value()};
+    seg.compute_checksum(0);
+    TCPSegment parsed;
+    if (!parse(parsed, serialize(seg), 0)) {
+      throw ExpectationViolation{"failed to parse serialized segment"};
+    }
+    const auto& opts = parsed.sender_message;
+    if (mss_ && opts.mss != mss_) {
+      throw ExpectationViolation{"unexpected MSS option"};
+    }
+    if (window_scale_ && opts.window_scale != window_scale_.value()) {
+      throw ExpectationViolation{"unexpected window scale option"};
+    }
+    if (ts_val_ && opts.ts_val != ts_val_.value()) {
+      throw ExpectationViolation{"unexpected timestamp option"};
+    }
+  }
+};
+
+struct ExpectNoSegment : public Expectation<TransceiverAndStream> {
+  std::string description() const override { return "no segment to send"; }
+  void execute(TransceiverAndStream& ts) const override {
+    if (const auto msg = ts.transceiver.maybe_send()) {
+      throw ExpectationViolation{
+          "expected no segment, but one with seqno " + to_string(msg->seqno) +
+          " was sent"};
+    }
+  }
+};
+
+struct SeqnosInFlight : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "sequence_numbers_in_flight"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.sequence_numbers_in_flight();
+  }
+};
+
+struct Cwnd : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "cwnd"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.congestion_control().cwnd();
+  }
+};
+
+struct Ssthresh : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "ssthresh"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.congestion_control().ssthresh();
+  }
+};
+
+struct DeliveryRate : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "delivery_rate"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.stats().delivery_rate;
+  }
+};
+
+struct PacingRate : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pacing_rate"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.stats().pacing_rate;
+  }
+};
+
+struct PacingBurst : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pacing_burst"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.stats().pacing_burst;
+  }
+};
+
+struct Rto : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rto_ms"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.stats().rto_ms;
+  }
+};
+
+//! 距最近一个计时器到期的时间，调用方据此决定何时 tick
+struct NextTimeout : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "next_timeout_ms"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.next_timeout_ms().value_or(UINT64_MAX);
+  }
+};
+
+struct TimerArmed : public ExpectBool<TransceiverAndStream> {
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "timer armed"; }
+  bool value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.next_timeout_ms().has_value();
+  }
+};
+
+struct BytesReceived : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "bytes_received"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.inbound.writer().bytes_pushed();
+  }
+};
+
+//! 检查 send_ack 回显的 TSecr
+struct ExpectTsEcr : public ExpectNumber<TransceiverAndStream, uint32_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "ts_ecr"; }
+  uint32_t value(TransceiverAndStream& ts) const override {
+    const auto msg =
+        ts.transceiver.send_ack(ts.reassembler, ts.inbound.writer());
+    if (!msg.ts_ecr) {
+      throw ExpectationViolation{"ack carries no timestamp"};
+    }
+    return msg.ts_ecr.value();
+  }
+};
+
+struct Mss : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "mss"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.stats().mss;
+  }
+};
+
+struct MtuProbes : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "mtu_probes"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.stats().mtu_probes;
+  }
+};
+
+struct WindowProbes : public ExpectNumber<TransceiverAndStream, uint64_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "window_probes"; }
+  uint64_t value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.stats().window_probes;
+  }
+};
+
+struct InRecovery : public ExpectBool<TransceiverAndStream> {
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "in_recovery"; }
+  bool value(TransceiverAndStream& ts) const override {
+    return ts.transceiver.in_recovery();
+  }
+};
+
+//! send_ack 的结果经过一次序列化和解析
+inline TCPReceiverMessage round_trip_ack(TransceiverAndStream& ts) {
+  TCPSegment seg{
+      .receiver_message = ts.transceiver.send_ack(ts.reassembler,
+                                                  ts.inbound.writer())};
+  seg.compute_checksum(0);
+  TCPSegment parsed;
+  if (!parse(parsed, serialize(seg), 0)) {
+    throw ExpectationViolation{"failed to parse serialized segment"};
+  }
+  return parsed.receiver_message;
+}
+
+//! 检查报头中的窗口字段 (扩大之前的值)
+struct ExpectWindowField
+    : public ExpectNumber<TransceiverAndStream, uint32_t> {
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "window field"; }
+  uint32_t value(TransceiverAndStream& ts) const override {
+    return round_trip_ack(ts).window_size;
+  }
+};
+
+//! 检查 send_ack 中的 SACK 块，并经过一次序列化和解析
+struct ExpectSackBlocks : public Expectation<TransceiverAndStream> {
+  std::vector<std::pair<uint64_t, uint64_t>> blocks_;
+
+  explicit ExpectSackBlocks(std::vector<std::pair<uint64_t, uint64_t>> blocks)
+      : blocks_(std::move(blocks)) {}
+
+  std::string description() const override {
+    std::ostringstream ss;
+    ss << "ack carries " << blocks_.size() << " sack block(s)";
+    for (const auto& [left, right] : blocks_) {
+      ss << " [" << left << ", " << right << ")";
+    }
+    return ss.str();
+  }
+
+  void execute(TransceiverAndStream& ts) const override {
+    const auto got = round_trip_ack(ts).sack_blocks;
+    if (got.size() != blocks_.size()) {
+      throw ExpectationViolation{"number of sack blocks", blocks_.size(),
+                                 got.size()};
+    }
+    for (size_t i = 0; i < got.size(); i++) {
+      const auto left = ts.isn + blocks_[i].first;
+      const auto right = ts.isn + blocks_[i].second;
+      if (!(got[i].left == left) || !(got[i].right == right)) {
+        throw ExpectationViolation{"sack block " + std::to_string(i) +
+                                   " does not match"};
+      }
+    }
+  }
+};
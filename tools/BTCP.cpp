@@ -29,7 +29,9 @@ static void show_usage(const char* argv0, const char* msg) {
            "------\n\n"
 
         << "   -l              监听模式                            "
-        << "            输入的 <host>:<port>.\n\n"
+        << "            输入的 <host>:<port>.\n"
+        << "   -C              监听时使用 SYN cookie                           "
+           "(关闭)\n\n"
 
         << "   -a <addr>       设置源地址 (仅客户端)                           "
         << LOCAL_ADDRESS_DFLT << "\n"
@@ -37,7 +39,19 @@ static void show_usage(const char* argv0, const char* msg) {
            "(随机)\n\n"
 
         << "   -w <winsz>      窗口大小 (bytes)                                "
-        << TCPConfig::DEFAULT_CAPACITY << "\n\n"
+        << TCPConfig::DEFAULT_CAPACITY << "\n"
+        << "   -W <maxwin>     窗口自动增长的上限 (bytes)                      "
+        << TCPConfig::MAX_RECV_CAPACITY_DFLT << "\n"
+        << "   -S <maxsnd>     发送缓冲区自动增长的上限 (bytes)                "
+        << TCPConfig::MAX_SEND_CAPACITY_DFLT << "\n"
+        << "   -m <mss>        最大报文载荷 (bytes)                            "
+        << TCPConfig::DEFAULT_MSS << "\n"
+        << "   -p              探测路径 MTU (RFC 4821)                         "
+           "(关闭)\n"
+        << "   -r <rate>       发送速率上限 (kbit/s)                           "
+           "(不限)\n"
+        << "   -N              关闭 Nagle 算法 (TCP_NODELAY)                   "
+           "(关闭)\n\n"
 
         << "   -t <tmout>      重传超时时间                                   "
            " "
@@ -46,6 +60,9 @@ static void show_usage(const char* argv0, const char* msg) {
         << "   -d <tundev>     连接到tun设备的设备号                           "
         << TUN_DFLT << "\n\n"
 
+        << "   -c <algo>       拥塞控制算法 (newreno, cubic, bbr)              "
+           "cubic\n\n"
+
         << "   -Lu <loss>      上行丢包率 (0-1的小数)                        "
            "  "
            "(0)\n"
@@ -87,6 +104,10 @@ get_config(const span<char*>& args) {
             listen = true;
             curr += 1;
 
+        } else if (strncmp("-C", args[curr], 3) == 0) {
+            c_fsm.syn_cookies = true;
+            curr += 1;
+
         } else if (strncmp("-a", args[curr], 3) == 0) {
             check_argc(args, curr, "ERROR: -a 未给定");
             source_address = args[curr + 1];
@@ -102,10 +123,52 @@ get_config(const span<char*>& args) {
             c_fsm.recv_capacity = strtol(args[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-W", args[curr], 3) == 0) {
+            check_argc(args, curr, "ERROR: -W 未给定");
+            c_fsm.max_recv_capacity = strtol(args[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-S", args[curr], 3) == 0) {
+            check_argc(args, curr, "ERROR: -S 未给定");
+            c_fsm.max_send_capacity = strtol(args[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-m", args[curr], 3) == 0) {
+            check_argc(args, curr, "ERROR: -m 未给定");
+            c_fsm.mss = strtol(args[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-p", args[curr], 3) == 0) {
+            c_fsm.mtu_probing = true;
+            curr += 1;
+
+        } else if (strncmp("-r", args[curr], 3) == 0) {
+            check_argc(args, curr, "ERROR: -r 未给定");
+            c_fsm.max_pacing_rate =
+                strtoull(args[curr + 1], nullptr, 0) * 1000 / 8;
+            curr += 2;
+
+        } else if (strncmp("-N", args[curr], 3) == 0) {
+            c_fsm.nodelay = true;
+            curr += 1;
+
         } else if (strncmp("-t", args[curr], 3) == 0) {
             check_argc(args, curr, "ERROR: -t 未给定");
             c_fsm.rt_timeout = strtol(args[curr + 1], nullptr, 0);
             curr += 2;
+        } else if (strncmp("-c", args[curr], 3) == 0) {
+            check_argc(args, curr, "ERROR: -c 未给定");
+            if (strcmp("newreno", args[curr + 1]) == 0) {
+                c_fsm.congestion_control = CongestionAlgorithm::NewReno;
+            } else if (strcmp("cubic", args[curr + 1]) == 0) {
+                c_fsm.congestion_control = CongestionAlgorithm::Cubic;
+            } else if (strcmp("bbr", args[curr + 1]) == 0) {
+                c_fsm.congestion_control = CongestionAlgorithm::Bbr;
+            } else {
+                show_usage(args[0], "ERROR: 未知的拥塞控制算法");
+                exit(1);
+            }
+            curr += 2;
         } else if (strncmp("-d", args[curr], 3) == 0) {
             check_argc(args, curr, "ERROR: -d 未给定");
             tundev = args[curr + 1];
@@ -210,6 +273,9 @@ int main(int argc, char** argv) {
                  << "传输速度 " << gigabits_per_second << " Gbit/s\n";
         }
         socket.wait_until_closed();
+        if (const auto& stats = socket.stats()) {
+            cerr << stats->to_string() << "\n";
+        }
     } catch (const exception& e) {
         cerr << "Exception: " << e.what() << endl;
         return EXIT_FAILURE;
@@ -5,10 +5,13 @@
 #include <iostream>
 #include <queue>
 #include <random>
+#include <vector>
 
 #include "buffer/stream_buffer.h"
 #include "config/tcp_config.h"
 #include "connect/b_socket.h"
+#include "connect/reassembler.h"
+#include "connect/transceiver.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -83,7 +86,181 @@ void streamBuffer_speed_test(
        << " Gbit/s.\n";
 }
 
-void program_body() { streamBuffer_speed_test(1e7, 32768, 789, 1500, 128); }
+//! 两个收发器在内存中直连，逐个报文确认，测量发送路径本身的开销
+void transceiver_speed_test(
+    const size_t input_len,  // NOLINT(bugprone-easily-swappable-parameters)
+    const size_t capacity,   // NOLINT(bugprone-easily-swappable-parameters)
+    const uint16_t mss)
+{
+  TCPConfig cfg;
+  cfg.send_capacity = capacity;
+  cfg.recv_capacity = capacity;
+  cfg.mss = mss;
+
+  Transceiver sender{cfg};
+  Transceiver receiver{cfg};
+  StreamBuffer outbound{capacity};
+  StreamBuffer inbound{capacity};
+  Reassembler reassembler;
+
+  // 握手：双方交换 SYN，协商窗口扩大等选项
+  {
+    StreamBuffer reverse{capacity};
+    Reassembler reverse_reassembler;
+    sender.push(outbound.reader());
+    receiver.receive_isn(sender.maybe_send().value(), reassembler,
+                         inbound.writer());
+    receiver.push(reverse.reader());
+    sender.receive_isn(receiver.maybe_send().value(), reverse_reassembler,
+                       reverse.writer());
+    sender.receive_ack(receiver.send_ack(reassembler, inbound.writer()));
+  }
+
+  // 每次写入相同的块，读出的数据按偏移量与块比较
+  string chunk(1500, 0);
+  for (size_t i = 0; i < chunk.size(); i++) {
+    chunk[i] = static_cast<char>(i % 251);
+  }
+  size_t bytes_written{};
+  size_t bytes_read{};
+  vector<TCPSenderMessage> segments;
+
+  const auto drain = [&] {
+    while (inbound.reader().bytes_buffered()) {
+      const auto view = inbound.reader().peek();
+      for (size_t i = 0; i < view.size(); i++) {
+        if (view[i] != chunk[(bytes_read + i) % chunk.size()]) {
+          throw runtime_error("Mismatch between data written and read");
+        }
+      }
+      bytes_read += view.size();
+      inbound.reader().pop(view.size());
+    }
+  };
+
+  const auto start_time = steady_clock::now();
+  while (!inbound.reader().is_finished()) {
+    while (bytes_written < input_len &&
+           outbound.writer().available_capacity() >= chunk.size()) {
+      outbound.writer().push(chunk);
+      bytes_written += chunk.size();
+    }
+    if (bytes_written >= input_len && !outbound.writer().is_closed()) {
+      outbound.writer().close();
+    }
+
+    sender.push(outbound.reader());
+    while (auto msg = sender.maybe_send()) {
+      segments.push_back(std::move(msg.value()));
+    }
+    if (segments.empty()) {
+      throw runtime_error("Transceiver stalled with nothing to send");
+    }
+
+    for (auto& seg : segments) {
+      receiver.receive_isn(std::move(seg), reassembler, inbound.writer());
+      drain();
+      sender.receive_ack(receiver.send_ack(reassembler, inbound.writer()));
+      sender.push(outbound.reader());
+    }
+    segments.clear();
+  }
+  const auto stop_time = steady_clock::now();
+
+  if (bytes_read != bytes_written) {
+    throw runtime_error("Mismatch between data written and read");
+  }
+
+  auto test_duration = duration_cast<duration<double>>(stop_time - start_time);
+  auto bits_per_second =
+      8 * static_cast<double>(bytes_read) / test_duration.count();
+
+  cout << "Transceiver with capacity=" << capacity << ", mss=" << mss
+       << " reached " << fixed
+       << setprecision(2) << bits_per_second / 1e9 << " Gbit/s.\n";
+}
+
+//! 应用每轮小块写入若干次，一轮结束后才收到确认，统计每 KB 的报文数
+void small_write_test(const size_t input_len, const size_t write_size,
+                      const bool nodelay)
+{
+  TCPConfig cfg;
+  cfg.nodelay = nodelay;
+
+  Transceiver sender{cfg};
+  Transceiver receiver{cfg};
+  StreamBuffer outbound{cfg.send_capacity};
+  StreamBuffer inbound{cfg.recv_capacity};
+  Reassembler reassembler;
+
+  {
+    StreamBuffer reverse{cfg.recv_capacity};
+    Reassembler reverse_reassembler;
+    sender.push(outbound.reader());
+    receiver.receive_isn(sender.maybe_send().value(), reassembler,
+                         inbound.writer());
+    receiver.push(reverse.reader());
+    sender.receive_isn(receiver.maybe_send().value(), reverse_reassembler,
+                       reverse.writer());
+    sender.receive_ack(receiver.send_ack(reassembler, inbound.writer()));
+  }
+
+  const string chunk(write_size, 'x');
+  size_t bytes_written{};
+  size_t segments{};
+  vector<TCPSenderMessage> in_flight;
+
+  while (!inbound.reader().is_finished()) {
+    for (size_t i = 0; i < 16 && bytes_written < input_len; i++) {
+      outbound.writer().push(chunk);
+      bytes_written += chunk.size();
+      sender.push(outbound.reader());
+      while (auto msg = sender.maybe_send()) {
+        in_flight.push_back(std::move(msg.value()));
+      }
+    }
+    if (bytes_written >= input_len && !outbound.writer().is_closed()) {
+      outbound.writer().close();
+      sender.push(outbound.reader());
+      while (auto msg = sender.maybe_send()) {
+        in_flight.push_back(std::move(msg.value()));
+      }
+    }
+    if (in_flight.empty()) {
+      throw runtime_error("Transceiver stalled with nothing to send");
+    }
+
+    // 一个 RTT 后，本轮的报文到达并被确认
+    for (auto& seg : in_flight) {
+      segments += seg.payload.empty() ? 0 : 1;
+      receiver.receive_isn(std::move(seg), reassembler, inbound.writer());
+      inbound.reader().pop(inbound.reader().bytes_buffered());
+    }
+    in_flight.clear();
+    sender.receive_ack(receiver.send_ack(reassembler, inbound.writer()));
+    sender.push(outbound.reader());
+    while (auto msg = sender.maybe_send()) {
+      in_flight.push_back(std::move(msg.value()));
+    }
+  }
+
+  cout << "Small writes of " << write_size << " bytes"
+       << (nodelay ? " (nodelay)" : " (Nagle)") << " used " << fixed
+       << setprecision(2)
+       << 1024.0 * static_cast<double>(segments) /
+              static_cast<double>(bytes_written)
+       << " segments/KB.\n";
+}
+
+void program_body() {
+  streamBuffer_speed_test(1e7, 32768, 789, 1500, 128);
+  transceiver_speed_test(1e8, 64000, 1000);
+  transceiver_speed_test(1e8, 64000, TCPConfig::DEFAULT_MSS);
+  transceiver_speed_test(1e8, 1 << 20, TCPConfig::DEFAULT_MSS);
+  transceiver_speed_test(1e8, 1 << 20, 8960);  // 9000 字节的巨型帧
+  small_write_test(1e6, 64, true);
+  small_write_test(1e6, 64, false);
+}
 
 int main() {
   try {
@@ -0,0 +1,444 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config/tcp_config.h"
+#include "connect/tcp_stack.h"
+#include "datagram/tcp_message.h"
+#include "utils/exception.h"
+#include "utils/parser.h"
+
+using namespace std;
+using namespace std::chrono;
+
+static void show_usage(const char* argv0, const char* msg) {
+  cout << "Usage: " << argv0 << " [options] accept|flood|bulk\n\n"
+       << "   -d <tundev>     tun 设备                    " << TUN_DFLT << "\n"
+       << "   -a <addr>       栈一端的地址                "
+       << LOCAL_ADDRESS_DFLT << "\n"
+       << "   -k <addr>       内核一端的地址 (bulk)       169.254.100.1\n"
+       << "   -p <port>       监听端口                    9000\n"
+       << "   -n <conns>      连接总数                    1000\n"
+       << "   -c <clients>    发起连接的线程数            4\n"
+       << "   -b <backlog>    监听队列的上限              "
+       << TCPConfig::LISTEN_BACKLOG_DFLT << "\n"
+       << "   -C              监听时使用 SYN cookie       (关闭)\n"
+       << "   -t <seconds>    flood 的持续时间            5\n"
+       << "   -r <rate>       flood 每秒伪造的 SYN 数     20000\n"
+       << "   -s <shards>     栈的分片 (线程) 数          1\n"
+       << "   -m <MiB>        bulk 每条连接发送的数据量   16\n"
+       << "   -O              启用 tun 的校验和与 TSO 卸载 (关闭)\n"
+       << "   -R              bulk 由内核一端发送         (关闭)\n\n"
+       << "   accept          内核一端不断连接栈的监听端口，"
+       << "测量每秒接受的连接数\n"
+       << "   flood           同时从伪造的地址发送 SYN，"
+       << "测量正常连接的接受速率\n"
+       << "   bulk            栈向内核一端打开 -n 条连接各发送 -m MiB，"
+       << "测量总吞吐量与每 MiB 的系统调用数\n\n"
+       << msg;
+}
+
+struct BenchConfig {
+  string tundev{TUN_DFLT};
+  string address{LOCAL_ADDRESS_DFLT};
+  uint16_t port{9000};
+  size_t connections{1000};
+  size_t clients{4};
+  size_t backlog{TCPConfig::LISTEN_BACKLOG_DFLT};
+  bool syn_cookies{};
+  unsigned seconds{5};
+  uint64_t flood_rate{20000};
+  string kernel_address{"169.254.100.1"};
+  size_t shards{1};
+  size_t megabytes{16};
+  bool offload{};
+  bool reverse{};
+};
+
+//! 栈的监听端口的内核地址
+static sockaddr_in listen_address(const BenchConfig& cfg) {
+  sockaddr_in peer{};
+  peer.sin_family = AF_INET;
+  peer.sin_port = htons(cfg.port);
+  inet_pton(AF_INET, cfg.address.c_str(), &peer.sin_addr);
+  return peer;
+}
+
+//! 内核一端的一个连接，连接后立即关闭；超时或失败时返回 false
+static bool kernel_connect(const sockaddr_in& peer) {
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  // SYN 被丢弃时内核按指数退避重传，限制等待的时间
+  const timeval timeout{.tv_sec = 1, .tv_usec = 0};
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const bool ok = ::connect(fd, reinterpret_cast<const sockaddr*>(&peer),
+                            sizeof(peer)) == 0;
+  ::close(fd);
+  return ok;
+}
+
+//! 内核一端的客户：依次连接 count 次
+static void kernel_clients(const BenchConfig& cfg, const size_t count,
+                           atomic<size_t>& failed) {
+  const sockaddr_in peer = listen_address(cfg);
+  for (size_t i = 0; i < count; ++i) {
+    failed += kernel_connect(peer) ? 0 : 1;
+  }
+}
+
+//! 伪造源地址的 SYN 洪泛：源地址取自 198.18.0.0/15 (RFC 2544)，
+//! 栈回复的 SYN-ACK 不会被任何主机确认
+static void syn_flood(const BenchConfig& cfg, const atomic_bool& stop,
+                      atomic<uint64_t>& sent) {
+  const int fd = CheckSystemCall("socket", ::socket(AF_INET, SOCK_RAW,
+                                                    IPPROTO_RAW));
+  const sockaddr_in peer = listen_address(cfg);
+  const uint32_t target = Address{cfg.address, cfg.port}.ipv4_numeric();
+  default_random_engine rd{random_device{}()};
+
+  const auto start = steady_clock::now();
+  while (not stop) {
+    // 按速率发送：超前时等待
+    const auto due = start + microseconds(sent * 1000000 / cfg.flood_rate);
+    if (due > steady_clock::now()) {
+      this_thread::sleep_until(due);
+    }
+
+    TCPSegment syn;
+    syn.sender_message = {.seqno = Wrap32{static_cast<uint32_t>(rd())},
+                          .SYN = true,
+                          .mss = TCPConfig::DEFAULT_MSS};
+    syn.udinfo.src_port = static_cast<uint16_t>(1024 + rd() % 60000);
+    syn.udinfo.dst_port = cfg.port;
+
+    IPv4Datagram dgram;
+    dgram.header.src = 0xc6120000 | (rd() & 0x1ffff);
+    dgram.header.dst = target;
+    dgram.header.len = dgram.header.hlen * 4 + syn.header_length();
+    syn.compute_checksum(dgram.header.pseudo_checksum());
+    dgram.header.compute_checksum();
+    dgram.payload = serialize(syn);
+
+    string packet;
+    for (const auto& buffer : serialize(dgram)) {
+      packet += string_view{buffer};
+    }
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (::sendto(fd, packet.data(), packet.size(), 0,
+                 reinterpret_cast<const sockaddr*>(&peer),
+                 sizeof(peer)) > 0) {
+      sent += 1;
+    }
+  }
+  ::close(fd);
+}
+
+static void accept_test(const BenchConfig& cfg) {
+  TCPStack stack(cfg.tundev, cfg.shards);
+  TCPConfig c_tcp;
+  c_tcp.syn_cookies = cfg.syn_cookies;
+  TCPStackListener listener =
+      stack.listen(c_tcp, Address{cfg.address, cfg.port}, cfg.backlog);
+
+  atomic<size_t> failed{};
+  vector<thread> clients;
+  const auto start = steady_clock::now();
+  for (size_t i = 0; i < cfg.clients; ++i) {
+    const size_t count = cfg.connections / cfg.clients +
+                         (i < cfg.connections % cfg.clients ? 1 : 0);
+    clients.emplace_back(kernel_clients, cref(cfg), count, ref(failed));
+  }
+
+  vector<TCPStackSocket> accepted;
+  accepted.reserve(cfg.connections);
+  while (accepted.size() + failed < cfg.connections) {
+    accepted.push_back(listener.accept());
+  }
+  const double seconds =
+      duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+  for (auto& client : clients) {
+    client.join();
+  }
+  for (auto& socket : accepted) {
+    socket.wait_until_closed();
+  }
+
+  cout << fixed << setprecision(2);
+  cout << "Accepted " << accepted.size() << " connections (" << failed
+       << " failed) in " << seconds << " s: "
+       << static_cast<double>(accepted.size()) / seconds
+       << " connections/s, " << cfg.clients << " clients, backlog "
+       << cfg.backlog << "\n";
+}
+
+static void flood_test(const BenchConfig& cfg) {
+  TCPStack stack(cfg.tundev, cfg.shards);
+  TCPConfig c_tcp;
+  c_tcp.syn_cookies = cfg.syn_cookies;
+  TCPStackListener listener =
+      stack.listen(c_tcp, Address{cfg.address, cfg.port}, cfg.backlog);
+
+  atomic_bool stop{false};
+  atomic<uint64_t> syns{};
+  thread flood(syn_flood, cref(cfg), cref(stop), ref(syns));
+
+  // 正常的客户在洪泛中持续连接，接受的连接随即关闭
+  atomic<size_t> connected{};
+  atomic<size_t> failed{};
+  vector<thread> clients;
+  for (size_t i = 0; i < cfg.clients; ++i) {
+    clients.emplace_back([&] {
+      const sockaddr_in peer = listen_address(cfg);
+      while (not stop) {
+        (kernel_connect(peer) ? connected : failed) += 1;
+      }
+    });
+  }
+  thread acceptor([&] {
+    try {
+      while (true) {
+        listener.accept();
+      }
+    } catch (const runtime_error&) {
+      // 监听关闭
+    }
+  });
+
+  size_t peak{};
+  const auto deadline = steady_clock::now() + seconds(cfg.seconds);
+  while (steady_clock::now() < deadline) {
+    this_thread::sleep_for(milliseconds(10));
+    peak = max(peak, stack.connections());
+  }
+  stop = true;
+  flood.join();
+  for (auto& client : clients) {
+    client.join();
+  }
+  listener.close();
+  acceptor.join();
+
+  cout << fixed << setprecision(2);
+  cout << (cfg.syn_cookies ? "SYN cookies" : "SYN queue") << ": "
+       << static_cast<double>(syns) / cfg.seconds << " spoofed SYNs/s, "
+       << static_cast<double>(connected) / cfg.seconds
+       << " connections/s accepted, " << failed
+       << " timed out, peak connections " << peak << "\n";
+}
+
+//! 本进程至今的 read/write 类系统调用次数 (/proc/self/io)
+static uint64_t io_syscalls() {
+  ifstream io("/proc/self/io");
+  uint64_t total = 0;
+  string key;
+  uint64_t value = 0;
+  while (io >> key >> value) {
+    if (key == "syscr:" or key == "syscw:") {
+      total += value;
+    }
+  }
+  return total;
+}
+
+//! 内核一端：接受 count 条连接，每条发送 bytes 字节后关闭；
+//! bytes 为零时读取并丢弃全部数据
+static void kernel_peer(const int listen_fd, const size_t count,
+                        const uint64_t bytes, atomic<uint64_t>& received) {
+  vector<thread> peers;
+  for (size_t i = 0; i < count; ++i) {
+    const int fd = CheckSystemCall("accept", ::accept(listen_fd, nullptr,
+                                                      nullptr));
+    peers.emplace_back([fd, bytes, &received] {
+      array<char, 65536> buffer{};
+      if (bytes) {
+        for (uint64_t sent = 0; sent < bytes;) {
+          const ssize_t n = ::write(fd, buffer.data(), buffer.size());
+          if (n <= 0) {
+            break;
+          }
+          sent += static_cast<uint64_t>(n);
+        }
+      } else {
+        ssize_t n = 0;
+        while ((n = ::read(fd, buffer.data(), buffer.size())) > 0) {
+          received += static_cast<uint64_t>(n);
+        }
+      }
+      ::close(fd);
+    });
+  }
+  for (auto& peer : peers) {
+    peer.join();
+  }
+}
+
+//! 栈一端的一条连接：发送 bytes 字节，或 (reverse 时) 读到 EOF
+static void stack_peer(TCPStackSocket& socket, const bool reverse,
+                       const uint64_t bytes, atomic<uint64_t>& received) {
+  socket.set_blocking(true);
+  if (reverse) {
+    string buffer;
+    while (not socket.eof()) {
+      buffer.clear();
+      socket.read(buffer);
+      received += buffer.size();
+    }
+  } else {
+    const string chunk(65536, 'x');
+    for (uint64_t sent = 0; sent < bytes; sent += chunk.size()) {
+      socket.write(chunk);
+    }
+  }
+  socket.wait_until_closed();
+}
+
+static void bulk_test(const BenchConfig& cfg) {
+  sockaddr_in kernel{};
+  kernel.sin_family = AF_INET;
+  kernel.sin_port = htons(cfg.port);
+  inet_pton(AF_INET, cfg.kernel_address.c_str(), &kernel.sin_addr);
+  const int listen_fd = CheckSystemCall("socket", ::socket(AF_INET,
+                                                           SOCK_STREAM, 0));
+  const int one = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  const auto* address = reinterpret_cast<const sockaddr*>(&kernel);
+  CheckSystemCall("bind", ::bind(listen_fd, address, sizeof(kernel)));
+  CheckSystemCall("listen", ::listen(listen_fd, SOMAXCONN));
+
+  const uint64_t total = uint64_t{cfg.megabytes} << 20;
+  atomic<uint64_t> received{};
+  thread kernel_thread(kernel_peer, listen_fd, cfg.connections,
+                       cfg.reverse ? total : 0, ref(received));
+
+  TCPStack stack(cfg.tundev, cfg.shards, cfg.offload);
+  // 每次使用不同的本端端口，避开内核一端上次留下的 TIME-WAIT
+  const auto base_port =
+      static_cast<uint16_t>(20000 + random_device{}() % 40000);
+  const uint64_t syscalls = io_syscalls();
+  const auto start = steady_clock::now();
+  vector<thread> peers;
+  for (size_t i = 0; i < cfg.connections; ++i) {
+    FdAdapterConfig c_ad;
+    c_ad.source =
+        Address{cfg.address, static_cast<uint16_t>(base_port + i)};
+    c_ad.destination = Address{cfg.kernel_address, cfg.port};
+    peers.emplace_back(
+        [&, socket = stack.connect(TCPConfig{}, c_ad)]() mutable {
+          stack_peer(socket, cfg.reverse, total, received);
+        });
+  }
+  for (auto& peer : peers) {
+    peer.join();
+  }
+  kernel_thread.join();
+  const double seconds =
+      duration_cast<duration<double>>(steady_clock::now() - start).count();
+  const double mib = static_cast<double>(received) / (1 << 20);
+  const double per_mib = static_cast<double>(io_syscalls() - syscalls) / mib;
+  ::close(listen_fd);
+
+  cout << fixed << setprecision(2);
+  cout << (cfg.reverse ? "Received " : "Sent ") << mib << " MiB over "
+       << cfg.connections << " connections in " << seconds << " s: "
+       << mib / seconds << " MiB/s, " << per_mib << " syscalls/MiB, "
+       << stack.shards() << " shards, "
+       << (stack.multi_queue() ? "multi-queue" : "single-queue")
+       << (cfg.offload ? " offloading" : "") << " tun, " << stack.steered()
+       << " segments steered\n";
+}
+
+int main(int argc, char** argv) {
+  try {
+    if (argc < 2) {
+      show_usage(argv[0], "ERROR: required arguments are missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    BenchConfig cfg;
+    int opt = 0;
+    while ((opt = getopt(argc, argv, "d:a:k:p:n:c:b:Ct:r:s:m:ORh")) != -1) {
+      switch (opt) {
+        case 'd':
+          cfg.tundev = optarg;
+          break;
+        case 'a':
+          cfg.address = optarg;
+          break;
+        case 'k':
+          cfg.kernel_address = optarg;
+          break;
+        case 'p':
+          cfg.port = static_cast<uint16_t>(stoul(optarg));
+          break;
+        case 'n':
+          cfg.connections = stoul(optarg);
+          break;
+        case 'c':
+          cfg.clients = max(stoul(optarg), 1UL);
+          break;
+        case 'b':
+          cfg.backlog = stoul(optarg);
+          break;
+        case 'C':
+          cfg.syn_cookies = true;
+          break;
+        case 't':
+          cfg.seconds = max(static_cast<unsigned>(stoul(optarg)), 1U);
+          break;
+        case 'r':
+          cfg.flood_rate = max(stoull(optarg), 1ULL);
+          break;
+        case 's':
+          cfg.shards = max(stoul(optarg), 1UL);
+          break;
+        case 'm':
+          cfg.megabytes = stoul(optarg);
+          break;
+        case 'O':
+          cfg.offload = true;
+          break;
+        case 'R':
+          cfg.reverse = true;
+          break;
+        default:
+          show_usage(argv[0], "");
+          return EXIT_FAILURE;
+      }
+    }
+
+    const string mode = optind < argc ? argv[optind] : "";
+    if (mode == "accept") {
+      accept_test(cfg);
+    } else if (mode == "flood") {
+      flood_test(cfg);
+    } else if (mode == "bulk") {
+      bulk_test(cfg);
+    } else {
+      show_usage(argv[0], ("ERROR: unknown mode " + mode + "\n").c_str());
+      return EXIT_FAILURE;
+    }
+  } catch (const exception& e) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -4,12 +4,18 @@ TUN_IP_PREFIX=169.254
 
 show_usage () {
     echo "Usage: $0 <start | stop | restart | check> [tunnum ...]"
+    echo
+    echo "Devices are created in multi-queue mode. A single-queue device from"
+    echo "an older version of this script is recreated by 'check', or by hand"
+    echo "with '$0 restart <tunnum>'."
     exit 1
 }
 
 start_tun () {
     local TUNNUM="$1" TUNDEV="tun$1"
-    ip tuntap add mode tun user "${SUDO_USER}" name "${TUNDEV}"
+    # multi_queue lets each TCPStack shard open its own queue, with the
+    # kernel steering flows between them; single-queue users still work
+    ip tuntap add mode tun multi_queue user "${SUDO_USER}" name "${TUNDEV}"
     ip addr add "${TUN_IP_PREFIX}.${TUNNUM}.1/24" dev "${TUNDEV}"
     ip link set dev "${TUNDEV}" up
     ip route change "${TUN_IP_PREFIX}.${TUNNUM}.0/24" dev "${TUNDEV}" rto_min 10ms
@@ -24,7 +30,9 @@ stop_tun () {
     local TUNDEV="tun$1"
     iptables -t nat -D PREROUTING -s ${TUN_IP_PREFIX}.${1}.0/24 -j CONNMARK --set-mark ${1}
     iptables -t nat -D POSTROUTING -j MASQUERADE -m connmark --mark ${1}
-    ip tuntap del mode tun name "$TUNDEV"
+    # devices created by older versions of this script are single-queue
+    ip tuntap del mode tun multi_queue name "$TUNDEV" 2>/dev/null ||
+        ip tuntap del mode tun name "$TUNDEV"
 }
 
 start_all () {
@@ -52,6 +60,8 @@ check_tun () {
     # make sure tun is healthy: device is up, ip_forward is set, and iptables is configured
     ip link show ${TUNDEV} &>/dev/null || return 1
     [ "$(cat /proc/sys/net/ipv4/ip_forward)" = "1" ] || return 2
+    # a single-queue device left over from an older version is recreated
+    ip -details link show ${TUNDEV} | grep -q multi_queue || return 3
 }
 
 check_sudo () {